@@ -0,0 +1,248 @@
+/*
+ * "tscsocket.c 2026-10-17 10:12:40
+ *
+ *  socket backend for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+/*
+	Device URI: tscsocket://host[:port]
+
+	Same job as the socket backend of CUPS, without copying the print data
+	through user space: a print file is sent with sendfile(), the filter
+	pipe is moved to the printer socket with splice(). The connection is
+	corked while data is queued and uncorked whenever the filter has
+	nothing more to send right now, so a command and its bitmap payload
+	leave in full segments.
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE			// splice()
+#endif
+
+#include "config.h"
+#include "common.h"
+#include "debug.h"
+#include "netio.h"
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+
+#define	BACKEND_OK				0		// CUPS_BACKEND_OK
+#define	BACKEND_FAILED			1		// CUPS_BACKEND_FAILED
+
+#define	CONNECT_RETRY_SEC		5		// Wait between connection attempts
+#define	DRAIN_TIMEOUT_MS		10000	// Wait for the printer to close
+#define	SPLICE_CHUNK			(256 * 1024)
+
+static ssize_t SendPipe(int fdOut, int fdIn);
+static ssize_t SendStream(int fdOut, int fdIn);
+static void DrainPrinter(int fd);
+
+/*
+	argv[1] = job-id
+	argv[2] = user
+	argv[3] = title
+	argv[4] = copies
+	argv[5] = options
+	argv[6] = file (optional)
+*/
+int main(int argc, char *argv[])
+{
+	int				fdIn = 0;
+	int				fdOut;
+	int				nCopies = 1;
+	int				i;
+	const char		*szURI;
+	struct stat		st;
+	ssize_t			nBytes = 0;
+
+	setbuf(stderr, NULL);
+
+	if ( argc == 1 )
+	{
+		// Device discovery, the URI is entered by hand
+		puts("network tscsocket \"Unknown\" \"TSC Label Printer (tscsocket)\"");
+		return BACKEND_OK;
+	}
+	if ( argc < 6 || argc > 7 )
+	{
+		fprintf(stderr, "Usage: %s job-id user title copies options [file]\n", argv[0]);
+		return BACKEND_FAILED;
+	}
+
+	if ( (szURI = getenv("DEVICE_URI")) == NULL )
+		szURI = argv[0];
+
+	if ( argc == 7 )
+	{
+		if ( (fdIn = open(argv[6], O_RDONLY)) < 0 )
+		{
+			Error_Log(LEVEL_ERROR, "Unable to open print file \"%s\" - %s\n", argv[6], strerror(errno));
+			return BACKEND_FAILED;
+		}
+		// Copies are done by the backend only for a print file
+		if ( atoi(argv[4]) > 1 )
+			nCopies = atoi(argv[4]);
+	}
+
+	signal(SIGPIPE, SIG_IGN);
+
+	fputs("STATE: +connecting-to-device\n", stderr);
+	while ( (fdOut = NetOpenDeviceURI(szURI)) < 0 )
+	{
+		Error_Log(LEVEL_INFO, "Unable to connect to printer; will retry in %d seconds...\n", CONNECT_RETRY_SEC);
+		sleep(CONNECT_RETRY_SEC);
+	}
+	fputs("STATE: -connecting-to-device\n", stderr);
+	Error_Log(LEVEL_INFO, "Connected to printer\n");
+
+	NetTuneStream(fdOut);
+
+	if ( fstat(fdIn, &st) == 0 && S_ISREG(st.st_mode) )
+	{
+		for (i=0; i<nCopies && nBytes >= 0; i++)
+		{
+			NetCork(fdOut, TRUE);
+			nBytes = NetSendFile(fdOut, fdIn, 0, st.st_size);
+			NetCork(fdOut, FALSE);
+		}
+	}
+	else if ( fstat(fdIn, &st) == 0 && S_ISFIFO(st.st_mode) )
+		nBytes = SendPipe(fdOut, fdIn);
+	else
+		nBytes = SendStream(fdOut, fdIn);
+
+	if ( nBytes < 0 )
+	{
+		Error_Log(LEVEL_ERROR, "Unable to send print data - %s\n", strerror(errno));
+		close(fdOut);
+		return BACKEND_FAILED;
+	}
+
+	DrainPrinter(fdOut);
+	close(fdOut);
+
+	if ( fdIn )
+		close(fdIn);
+
+	Error_Log(LEVEL_INFO, "Print file sent\n");
+	return BACKEND_OK;
+}
+
+// Move the filter pipe to the printer socket, uncork when the pipe runs dry.
+// Printer replies go to the back channel meanwhile, filters poll the status.
+ssize_t SendPipe(int fdOut, int fdIn)
+{
+	struct pollfd	pfd[2];
+	char			buffer[1024];
+	ssize_t			nTotal = 0;
+	ssize_t			nBytes = 0;
+	BOOL			bCork = FALSE;
+
+	pfd[0].fd = fdIn;
+	pfd[0].events = POLLIN;
+	pfd[1].fd = fdOut;
+	pfd[1].events = POLLIN;
+
+	while (1)
+	{
+		int		n = poll(pfd, 2, bCork ? 0 : -1);
+
+		if ( n < 0 && errno == EINTR )
+			continue;
+		if ( n < 0 )
+			return -1;
+		if ( n == 0 )
+		{
+			NetCork(fdOut, FALSE);
+			bCork = FALSE;
+			continue;
+		}
+
+		if ( pfd[1].revents & POLLIN )
+		{
+			if ( (nBytes = read(fdOut, buffer, sizeof(buffer))) > 0 )
+				write(3, buffer, nBytes);
+			else
+				pfd[1].fd = -1;
+		}
+		if ( !(pfd[0].revents & (POLLIN | POLLHUP | POLLERR)) )
+			continue;
+
+		if ( !bCork )
+		{
+			NetCork(fdOut, TRUE);
+			bCork = TRUE;
+		}
+
+		nBytes = splice(fdIn, NULL, fdOut, NULL, SPLICE_CHUNK, SPLICE_F_MOVE | SPLICE_F_MORE | SPLICE_F_NONBLOCK);
+		if ( nBytes < 0 && (errno == EINTR || errno == EAGAIN) )
+			continue;
+		if ( nBytes < 0 && nTotal == 0 && errno == EINVAL )
+			return SendStream(fdOut, fdIn);
+		if ( nBytes <= 0 )
+			break;
+		nTotal += nBytes;
+	}
+
+	NetCork(fdOut, FALSE);
+	return nBytes < 0 ? -1 : nTotal;
+}
+
+ssize_t SendStream(int fdOut, int fdIn)
+{
+	char		buffer[65536];
+	ssize_t		nTotal = 0;
+	ssize_t		nBytes;
+
+	while ( (nBytes = read(fdIn, buffer, sizeof(buffer))) != 0 )
+	{
+		if ( nBytes < 0 )
+		{
+			if ( errno == EINTR )
+				continue;
+			return -1;
+		}
+		if ( NetWriteAll(fdOut, buffer, nBytes) < 0 )
+			return -1;
+		nTotal += nBytes;
+	}
+	return nTotal;
+}
+
+// Closing with unread status bytes would reset the connection and may drop
+// the end of the job, so let the printer close first.
+void DrainPrinter(int fd)
+{
+	struct pollfd	pfd;
+	char			buffer[1024];
+	ssize_t			nBytes;
+
+	shutdown(fd, SHUT_WR);
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	while ( poll(&pfd, 1, DRAIN_TIMEOUT_MS) > 0 )
+	{
+		if ( (nBytes = read(fd, buffer, sizeof(buffer))) <= 0 )
+			break;
+		// Back channel of the filters, ignored when there is none
+		write(3, buffer, nBytes);
+	}
+}
@@ -24,6 +24,14 @@
 #include "config.h"
 #include "common.h"
 #include <time.h>
+#include <sys/time.h>
+
+#define	B2(n)	n, n + 1, n + 1, n + 2
+#define	B4(n)	B2(n), B2(n + 1), B2(n + 1), B2(n + 2)
+#define	B6(n)	B4(n), B4(n + 1), B4(n + 1), B4(n + 2)
+
+// Set bits of a byte
+const BYTE g_BitCount[256] = { B6(0), B6(1), B6(1), B6(2) };
 
 WORD	ENDIEN16(WORD x)
 {
@@ -39,6 +47,15 @@ DWORD	ENDIEN32(DWORD x)
 	return (((DWORD)p[3]) << 24) | (((DWORD)p[2]) << 16) | (((DWORD)p[1]) << 8) | p[0];
 }
 
+// Seconds since the epoch, for durations
+double	GetSeconds(void)
+{
+	struct timeval	tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
 size_t my_strlcpy(char *dst, const char *src, size_t dst_sz)
 {
     size_t n;
@@ -163,12 +163,17 @@ typedef SIZE               *PSIZEL, *LPSIZEL;
 #define	POINT2MM(x)				((x)*25.4/72)
 #define	POINT2DOT(x, dpi)		((x)*(dpi)/72)
 
+#define	BITCOUNT(b)				(g_BitCount[(BYTE)(b)])
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+extern const BYTE g_BitCount[256];
+
 WORD	ENDIEN16(WORD x);
 DWORD	ENDIEN32(DWORD x);
+double	GetSeconds(void);
 
 #ifndef HAVE_STRLCPY
 	size_t my_strlcpy(char *dst, const char *src, size_t dst_sz);
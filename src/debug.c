@@ -193,7 +193,7 @@ void DumpDevmode(DEVMODE *pdm)
 		Error_Log(ErrorLevel, "DEVMODE.dmGapOffset        = %f\n", pdm->dmGapOffset);
 		Error_Log(ErrorLevel, "DEVMODE.dmPostAction       = %d\n", pdm->dmPostAction);
 		Error_Log(ErrorLevel, "DEVMODE.dmOccurrence       = %d\n", pdm->dmOccurrence);
-		Error_Log(ErrorLevel, "DEVMODE.dmCutInterval      = %d\n", pdm->dmCutInterval);
+		Error_Log(ErrorLevel, "DEVMODE.dmCutInterval      = %u\n", pdm->dmCutInterval);
 
 		Error_Log(ErrorLevel, "DEVMODE.dmFeedOffset       = %f\n", pdm->dmFeedOffset);
 		Error_Log(ErrorLevel, "DEVMODE.dmVerticalOffset   = %f\n", pdm->dmVerticalOffset);
@@ -214,7 +214,35 @@ void DumpDevmode(DEVMODE *pdm)
 		Error_Log(ErrorLevel, "DEVMODE.dmMetric       = %d\n", pdm->dmMetric);
 		Error_Log(ErrorLevel, "DEVMODE.dmPrintQuality = %d\n", pdm->dmPrintQuality);
 		Error_Log(ErrorLevel, "DEVMODE.dmYResolution  = %d\n", pdm->dmYResolution);
-		Error_Log(ErrorLevel, "DEVMODE.dmCopies       = %d\n", pdm->dmCopies);
+		Error_Log(ErrorLevel, "DEVMODE.dmCopies       = %u\n", pdm->dmCopies);
+		Error_Log(ErrorLevel, "DEVMODE.dmLabelSession = %d\n", pdm->dmLabelSession);
+		Error_Log(ErrorLevel, "DEVMODE.dmSetupCache   = %d\n", pdm->dmSetupCache);
+		Error_Log(ErrorLevel, "DEVMODE.dmSetupReset   = %d\n", pdm->dmSetupReset);
+		Error_Log(ErrorLevel, "DEVMODE.dmSetupTimeout = %d\n", pdm->dmSetupTimeout);
+		Error_Log(ErrorLevel, "DEVMODE.dmPrinterPool  = %s\n", pdm->dmPrinterPool);
+		Error_Log(ErrorLevel, "DEVMODE.dmStatusPolling = %d\n", pdm->dmStatusPolling);
+		Error_Log(ErrorLevel, "DEVMODE.dmCheckpoint   = %d\n", pdm->dmCheckpoint);
+		Error_Log(ErrorLevel, "DEVMODE.dmResumeJob    = %d\n", pdm->dmResumeJob);
+		Error_Log(ErrorLevel, "DEVMODE.dmJobCache     = %d\n", pdm->dmJobCache);
+		Error_Log(ErrorLevel, "DEVMODE.dmJobCacheSize = %d\n", pdm->dmJobCacheSize);
+		Error_Log(ErrorLevel, "DEVMODE.dmJobCacheKey  = %s\n", pdm->dmJobCacheKey);
+		Error_Log(ErrorLevel, "DEVMODE.dmLabelsAcross = %d\n", pdm->dmLabelsAcross);
+		Error_Log(ErrorLevel, "DEVMODE.dmColumnGap    = %.2f\n", pdm->dmColumnGap);
+		Error_Log(ErrorLevel, "DEVMODE.dmLinerLeft    = %.2f\n", pdm->dmLinerLeft);
+		Error_Log(ErrorLevel, "DEVMODE.dmLinerRight   = %.2f\n", pdm->dmLinerRight);
+		Error_Log(ErrorLevel, "DEVMODE.dmAutoLength   = %d\n", pdm->dmAutoLength);
+		Error_Log(ErrorLevel, "DEVMODE.dmAutoLengthMargin = %.2f\n", pdm->dmAutoLengthMargin);
+		Error_Log(ErrorLevel, "DEVMODE.dmAdaptiveSpeed = %d\n", pdm->dmAdaptiveSpeed);
+		Error_Log(ErrorLevel, "DEVMODE.dmSpeedMin     = %d\n", pdm->dmSpeedMin);
+		Error_Log(ErrorLevel, "DEVMODE.dmSpeedMax     = %d\n", pdm->dmSpeedMax);
+		Error_Log(ErrorLevel, "DEVMODE.dmAsyncIO      = %d\n", pdm->dmAsyncIO);
+		Error_Log(ErrorLevel, "DEVMODE.dmRasterMemory = %u\n", pdm->dmRasterMemory);
+		Error_Log(ErrorLevel, "DEVMODE.dmRasterTime   = %u\n", pdm->dmRasterTime);
+		Error_Log(ErrorLevel, "DEVMODE.dmBarcodes     = %d\n", pdm->dmBarcodes);
+		Error_Log(ErrorLevel, "DEVMODE.dmCutAtEnd     = %d\n", pdm->dmCutAtEnd);
+		Error_Log(ErrorLevel, "DEVMODE.dmMaxPaperWidth= %.2f\n", pdm->dmMaxPaperWidth);
+		Error_Log(ErrorLevel, "DEVMODE.dmMaxBitmap    = %u\n", pdm->dmMaxBitmap);
+		Error_Log(ErrorLevel, "DEVMODE.dmPageBoxClip  = %d\n", pdm->dmPageBoxClip);
 	}
 	else
 	{
@@ -23,6 +23,7 @@
 #include "debug.h"
 #include "devmode.h"
 #include "devoption.h"
+#include "prncaps.h"
 
 float			g_fCurPaperSizeHeight = 0.0;
 float			g_fCurPaperSizeWidth = 0.0;
@@ -541,6 +542,17 @@ SetDevmodeFromOptions(CUPSLIB_FUNCTION* cups, ppd_file_t* ppd, DEVMODE* devMode,
 		}
 	}
 
+	// What the model can take, the resolution only when the options gave none
+	{
+		PRINTERCAPS		caps;
+
+		GetPrinterCaps(cups, ppd, &caps);
+		devMode->dmMaxPaperWidth = caps.fMaxPaperWidth;
+		devMode->dmMaxBitmap = caps.dwMaxBitmap;
+		if ( devMode->dmPrintQuality == 0 )
+			devMode->dmPrintQuality = caps.wDpi;
+	}
+
 	// Valid the value to check whether is on the range or not
 	{
 		float			fValueTmp;
@@ -1081,6 +1093,197 @@ SetDevmodeFromOption(CUPSLIB_FUNCTION* cups, ppd_file_t* ppd, DEVMODE* devMode,
 			}
 		}
 		break;
+
+		// Output
+	case OPTID_OUTLABELSESSION:
+		{
+			if ( szOpValue && !strcasecmp(szOpValue, DMBOOL_TRUE) )
+				devMode->dmLabelSession = DMLABELSESSION_ON;
+			else
+				devMode->dmLabelSession = DMLABELSESSION_OFF;
+		}
+		break;
+	case OPTID_OUTSETUPCACHE:
+		{
+			if ( szOpValue && !strcasecmp(szOpValue, DMBOOL_TRUE) )
+				devMode->dmSetupCache = DMSETUPCACHE_ON;
+			else
+				devMode->dmSetupCache = DMSETUPCACHE_OFF;
+		}
+		break;
+	case OPTID_OUTSETUPRESET:
+		{
+			devMode->dmSetupReset = ( szOpValue && !strcasecmp(szOpValue, DMBOOL_TRUE) );
+		}
+		break;
+	case OPTID_OUTSETUPTIMEOUT:
+		{
+			if ( szOpValue == NULL || atoi(szOpValue) <= 0 )
+				devMode->dmSetupTimeout = SETUPTIMEOUT_DEF_VALUE;
+			else
+				devMode->dmSetupTimeout = atoi(szOpValue);
+		}
+		break;
+	case OPTID_OUTSTATUSPOLLING:
+		{
+			if ( szOpValue && !strcasecmp(szOpValue, DMBOOL_TRUE) )
+				devMode->dmStatusPolling = DMSTATUSPOLLING_ON;
+			else
+				devMode->dmStatusPolling = DMSTATUSPOLLING_OFF;
+		}
+		break;
+	case OPTID_OUTCHECKPOINT:
+		{
+			if ( szOpValue && !strcasecmp(szOpValue, DMBOOL_TRUE) )
+				devMode->dmCheckpoint = DMCHECKPOINT_ON;
+			else
+				devMode->dmCheckpoint = DMCHECKPOINT_OFF;
+		}
+		break;
+	case OPTID_OUTRESUMEJOB:
+		{
+			if ( szOpValue == NULL || atoi(szOpValue) <= 0 )
+				devMode->dmResumeJob = 0;
+			else
+				devMode->dmResumeJob = atoi(szOpValue);
+		}
+		break;
+	case OPTID_OUTJOBCACHE:
+		{
+			if ( szOpValue && !strcasecmp(szOpValue, DMBOOL_TRUE) )
+				devMode->dmJobCache = DMJOBCACHE_ON;
+			else
+				devMode->dmJobCache = DMJOBCACHE_OFF;
+		}
+		break;
+	case OPTID_OUTJOBCACHESIZE:
+		{
+			if ( szOpValue == NULL || atoi(szOpValue) <= 0 )
+				devMode->dmJobCacheSize = JOBCACHESIZE_DEF_VALUE;
+			else
+				devMode->dmJobCacheSize = atoi(szOpValue);
+		}
+		break;
+	case OPTID_OUTPRINTERPOOL:
+		{
+			memset(devMode->dmPrinterPool, 0, sizeof(devMode->dmPrinterPool));
+			if ( szOpValue )
+				strncpy(devMode->dmPrinterPool, szOpValue, sizeof(devMode->dmPrinterPool) - 1);
+		}
+		break;
+	case OPTID_OUTLABELSACROSS:
+		{
+			if ( szOpValue == NULL || atoi(szOpValue) <= 1 )
+				devMode->dmLabelsAcross = 1;
+			else
+				devMode->dmLabelsAcross = min(atoi(szOpValue), LABELSACROSS_MAX_VALUE);
+		}
+		break;
+	case OPTID_OUTLABELCOLUMNGAP:
+		{
+			if ( szOpValue )
+				devMode->dmColumnGap = OnValidValue(atof(szOpValue), LINERMARGIN_MIN_VALUE*72, LINERMARGIN_MAX_VALUE*72);
+		}
+		break;
+	case OPTID_OUTAUTOLENGTH:
+		{
+			if ( szOpValue && !strcasecmp(szOpValue, DMBOOL_TRUE) )
+				devMode->dmAutoLength = DMAUTOLENGTH_ON;
+			else
+				devMode->dmAutoLength = DMAUTOLENGTH_OFF;
+		}
+		break;
+	case OPTID_OUTAUTOLENGTHMARGIN:
+		{
+			if ( szOpValue )
+				devMode->dmAutoLengthMargin = OnValidValue(atof(szOpValue), AUTOLENGTHMARGIN_MIN_VALUE*72, AUTOLENGTHMARGIN_MAX_VALUE*72);
+		}
+		break;
+	case OPTID_OUTADAPTIVESPEED:
+		{
+			if ( szOpValue && !strcasecmp(szOpValue, DMBOOL_TRUE) )
+				devMode->dmAdaptiveSpeed = DMADAPTIVESPEED_ON;
+			else
+				devMode->dmAdaptiveSpeed = DMADAPTIVESPEED_OFF;
+		}
+		break;
+	case OPTID_OUTSPEEDMIN:
+		{
+			if ( szOpValue == NULL || atoi(szOpValue) <= 0 )
+				devMode->dmSpeedMin = SPEEDMIN_DEF_VALUE;
+			else
+				devMode->dmSpeedMin = atoi(szOpValue);
+		}
+		break;
+	case OPTID_OUTSPEEDMAX:
+		{
+			if ( szOpValue == NULL || atoi(szOpValue) <= 0 )
+				devMode->dmSpeedMax = 0;
+			else
+				devMode->dmSpeedMax = atoi(szOpValue);
+		}
+		break;
+	case OPTID_OUTASYNCIO:
+		{
+			if ( szOpValue && !strcasecmp(szOpValue, DMBOOL_TRUE) )
+				devMode->dmAsyncIO = DMASYNCIO_ON;
+			else
+				devMode->dmAsyncIO = DMASYNCIO_OFF;
+		}
+		break;
+	case OPTID_OUTRASTERMEMORY:
+		{
+			if ( szOpValue == NULL || atoi(szOpValue) <= 0 )
+				devMode->dmRasterMemory = RASTERMEMORY_DEF_VALUE;
+			else
+				devMode->dmRasterMemory = atoi(szOpValue);
+		}
+		break;
+	case OPTID_OUTRASTERTIME:
+		{
+			if ( szOpValue == NULL || atoi(szOpValue) <= 0 )
+				devMode->dmRasterTime = 0;
+			else
+				devMode->dmRasterTime = atoi(szOpValue);
+		}
+		break;
+	case OPTID_OUTBARCODES:
+		{
+			if ( szOpValue && !strcasecmp(szOpValue, DMBOOL_TRUE) )
+				devMode->dmBarcodes = DMBARCODES_ON;
+			else
+				devMode->dmBarcodes = DMBARCODES_OFF;
+		}
+		break;
+	case OPTID_OUTCUTATEND:
+		{
+			if ( szOpValue && !strcasecmp(szOpValue, DMBOOL_TRUE) )
+				devMode->dmCutAtEnd = DMCUTATEND_ON;
+			else
+				devMode->dmCutAtEnd = DMCUTATEND_OFF;
+		}
+		break;
+
+	case OPTID_OUTPAGEBOXCLIP:
+		{
+			if ( szOpValue && !strcasecmp(szOpValue, DMBOOL_TRUE) )
+				devMode->dmPageBoxClip = DMPAGEBOXCLIP_ON;
+			else
+				devMode->dmPageBoxClip = DMPAGEBOXCLIP_OFF;
+		}
+		break;
+	case OPTID_EDITSTOCKLINERL:
+		{
+			if ( szOpValue )
+				devMode->dmLinerLeft = OnValidValue(atof(szOpValue), LINERMARGIN_MIN_VALUE*72, LINERMARGIN_MAX_VALUE*72);
+		}
+		break;
+	case OPTID_EDITSTOCKLINERR:
+		{
+			if ( szOpValue )
+				devMode->dmLinerRight = OnValidValue(atof(szOpValue), LINERMARGIN_MIN_VALUE*72, LINERMARGIN_MAX_VALUE*72);
+		}
+		break;
 	default:
 		break;
 	}
@@ -32,6 +32,8 @@
 #define DM_HEADER_MARKER   ((WORD) ('M' << 8) | 'D')
 
 #define DM_USER_COMMOND_LENGTH			1024
+#define DM_PRINTERPOOL_LENGTH			512
+#define DM_JOBCACHEKEY_LENGTH			65		// SHA-256 in hex
 
 typedef struct {
 	WORD	dmType;					// DM_HEADER_MARKER
@@ -54,7 +56,7 @@ typedef struct {
 	float	dmGapOffset;			// Point (1/72inch)
 	WORD	dmPostAction;
 	WORD	dmOccurrence;
-	WORD	dmCutInterval;
+	DWORD	dmCutInterval;
 
 	float	dmFeedOffset;			// Point (1/72inch)
 	float	dmVerticalOffset;		// Point (1/72inch)
@@ -87,13 +89,44 @@ typedef struct {
 	WORD	dmPrintQuality;
 	WORD	dmXResolution;
 	WORD	dmYResolution;
-	WORD	dmCopies;
+	DWORD	dmCopies;
 
 	// Use When Print
-	WORD	dmDocPages;
-	WORD	dmOutPages;
+	DWORD	dmDocPages;
+	DWORD	dmOutPages;
 	WORD	dmCollate;
 
+	// Output
+	WORD	dmLabelSession;			// Hand pages to tsplsessiond
+	WORD	dmSetupCache;			// Skip unchanged job setup commands
+	WORD	dmSetupReset;			// Force the full job setup
+	DWORD	dmSetupTimeout;			// Seconds a cached printer setup is trusted
+	CHAR	dmPrinterPool[DM_PRINTERPOOL_LENGTH];	// Device URIs separated by ','
+	WORD	dmStatusPolling;		// Poll printer status between labels
+	WORD	dmCheckpoint;			// Keep a resume checkpoint of the job
+	DWORD	dmResumeJob;			// Job id to resume, 0 = none
+	WORD	dmJobCache;				// Reprint identical jobs from the output cache
+	DWORD	dmJobCacheSize;			// MB, bound of the output cache
+	CHAR	dmJobCacheKey[DM_JOBCACHEKEY_LENGTH];	// Document and settings hash, set by the filter
+	WORD	dmJobCacheHit;			// Output of dmJobCacheKey is cached
+	WORD	dmLabelsAcross;			// Logical labels per physical row, 0/1 = one
+	float	dmColumnGap;			// Point (1/72inch), between label columns
+	float	dmLinerLeft;			// Point (1/72inch), liner left of the first column
+	float	dmLinerRight;			// Point (1/72inch), liner right of the last column
+	WORD	dmAutoLength;			// Continuous media, labels as long as their content
+	float	dmAutoLengthMargin;		// Point (1/72inch), after the last printed row
+	WORD	dmAdaptiveSpeed;		// dmPrintSpeed of each label from its content
+	WORD	dmSpeedMin;				// 1/10 inch/sec, densest labels
+	WORD	dmSpeedMax;				// 1/10 inch/sec, blank labels, 0 = dmPrintSpeed
+	WORD	dmAsyncIO;				// Output written behind through io_uring
+	DWORD	dmRasterMemory;			// MB, page buffers of one raster page
+	DWORD	dmRasterTime;			// Second, reading the raster document, 0 = no limit
+	WORD	dmBarcodes;				// Code 128 and EAN symbols of the raster sent as BARCODE
+	WORD	dmCutAtEnd;				// Cut after job: cutter off, CUT after the last label
+	float	dmMaxPaperWidth;		// Point, widest paper of the model, 0 = not known
+	DWORD	dmMaxBitmap;			// Bytes of data in one BITMAP command, 0 = no limit
+	WORD	dmPageBoxClip;			// PostScript pages rendered for their %%PageBoundingBox only
+
 } DEVMODE;
 
 // dmFields
@@ -179,6 +212,73 @@ typedef struct {
 #define DMMETRIC_INCH				0		// inch
 #define DMMETRIC_MM					1		// mm
 
+// dmLabelSession
+#define DMLABELSESSION_OFF			0
+#define DMLABELSESSION_ON			1
+
+// dmSetupCache
+#define DMSETUPCACHE_OFF			0
+#define DMSETUPCACHE_ON				1
+
+// dmStatusPolling
+#define DMSTATUSPOLLING_OFF			0
+#define DMSTATUSPOLLING_ON			1
+
+// dmCheckpoint
+#define DMCHECKPOINT_OFF			0
+#define DMCHECKPOINT_ON				1
+
+// dmJobCache
+#define DMJOBCACHE_OFF				0
+#define DMJOBCACHE_ON				1
+
+// dmAutoLength
+#define DMAUTOLENGTH_OFF			0
+#define DMAUTOLENGTH_ON				1
+
+// dmAdaptiveSpeed
+#define DMADAPTIVESPEED_OFF			0
+#define DMADAPTIVESPEED_ON			1
+
+// dmAsyncIO
+#define DMASYNCIO_OFF				0
+#define DMASYNCIO_ON				1
+
+// dmBarcodes
+#define DMBARCODES_OFF				0
+#define DMBARCODES_ON				1
+
+// dmCutAtEnd
+#define DMCUTATEND_OFF				0
+#define DMCUTATEND_ON				1
+
+// dmPageBoxClip
+#define DMPAGEBOXCLIP_OFF			0
+#define DMPAGEBOXCLIP_ON			1
+
+// range of dmSetupTimeout value
+#define SETUPTIMEOUT_DEF_VALUE		600		//(sec)
+
+// range of dmJobCacheSize value
+#define JOBCACHESIZE_DEF_VALUE		64		//(MB)
+
+// range of dmRasterMemory value
+#define RASTERMEMORY_DEF_VALUE		256		//(MB)
+
+// range of dmLabelsAcross value
+#define LABELSACROSS_MAX_VALUE		8
+
+// range of dmSpeedMin value
+#define SPEEDMIN_DEF_VALUE			20		//(1/10 inch/sec)
+
+// range of dmAutoLengthMargin value
+#define AUTOLENGTHMARGIN_MAX_VALUE	1		//(in)
+#define AUTOLENGTHMARGIN_MIN_VALUE	0
+
+// range of dmColumnGap, dmLinerLeft, dmLinerRight value
+#define LINERMARGIN_MAX_VALUE		4		//(in)
+#define LINERMARGIN_MIN_VALUE		0
+
 #define TSC_LANG_ZH_CN				"zh_CN"
 #define TSC_LANG_ZH_TW				"zh_TW"
 #define TSC_LANG_EN					"en"
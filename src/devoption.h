@@ -94,6 +94,31 @@
 
 #define OPTID_METRIC							601
 
+// Output
+#define	OPTID_OUTLABELSESSION					701		// Hand pages to the resident label session service
+#define	OPTID_OUTSETUPCACHE						702		// Skip job setup commands the printer already has
+#define	OPTID_OUTSETUPRESET						703		// Force the full job setup
+#define	OPTID_OUTSETUPTIMEOUT					704		// Seconds a cached printer setup is trusted
+#define	OPTID_OUTPRINTERPOOL					705		// Device URIs to split the labels across
+#define	OPTID_OUTSTATUSPOLLING					706		// Poll printer status between labels
+#define	OPTID_OUTCHECKPOINT						707		// Keep a checkpoint to resume a failed job
+#define	OPTID_OUTRESUMEJOB						708		// Job id whose checkpoint the job resumes
+#define	OPTID_OUTJOBCACHE						709		// Reprint identical jobs from the output cache
+#define	OPTID_OUTJOBCACHESIZE					710		// MB, bound of the output cache
+#define	OPTID_OUTLABELSACROSS					711		// Logical labels side by side on the liner
+#define	OPTID_OUTLABELCOLUMNGAP					712		// Point, gap between label columns
+#define	OPTID_OUTAUTOLENGTH						713		// Continuous media, size each label to its content
+#define	OPTID_OUTAUTOLENGTHMARGIN				714		// Point, fed after the last printed row
+#define	OPTID_OUTADAPTIVESPEED					715		// Print speed of each label from its content
+#define	OPTID_OUTSPEEDMIN						716		// 1/10 inch/sec, speed of the densest labels
+#define	OPTID_OUTSPEEDMAX						717		// 1/10 inch/sec, speed of blank labels
+#define	OPTID_OUTASYNCIO						718		// Printer output through io_uring
+#define	OPTID_OUTRASTERMEMORY					719		// MB, largest page the filter keeps
+#define	OPTID_OUTRASTERTIME						720		// Second, longest a document may take to read
+#define	OPTID_OUTBARCODES						721		// Code 128 and EAN symbols in the raster sent as BARCODE
+#define	OPTID_OUTCUTATEND						722		// Cut after job by CUT, no label count needed
+#define	OPTID_OUTPAGEBOXCLIP					723		// PostScript pages rendered for their %%PageBoundingBox only
+
 
 typedef struct {
 	DWORD	id;
@@ -119,6 +144,8 @@ static TSC_OPTION_NAME_T g_tsc_options[] = {
 		{OPTID_STOCKINTERVAL, 						0,	"Interval"},				// PPD Interval
 		{OPTID_STOCKFEEDOFFSET,						0,	"FeedOffset"},				// PPD Feed Offset
 		{OPTID_STOCKVERTICALOFFSET,					0,	"VerticalOffset"},			// PPD Vertical Offset
+		{OPTID_EDITSTOCKLINERL,						0,	"LinerLeft"},				// Liner margin left of the first label column
+		{OPTID_EDITSTOCKLINERR,						0,	"LinerRight"},				// Liner margin right of the last label column
 
 		// Option
 		{OPTID_OPTIONPRINTERSPEED, 					0,	"PrintSpeed"},				// PPD Printer Speed
@@ -148,7 +175,32 @@ static TSC_OPTION_NAME_T g_tsc_options[] = {
 		{OPTID_USERCMDSTARTLABELNOCTRL,				0,	"OriStartLabel"},
 		{OPTID_USERCMDENDLABELNOCTRL,				0,	"OriEndLabel"},
 		{OPTID_USERCMDENDJOBNOCTRL,					0,	"OriEndJob"},
-		{OPTID_METRIC,								0,  "OptionDisplayUnit"}
+		{OPTID_METRIC,								0,  "OptionDisplayUnit"},
+
+		// Output
+		{OPTID_OUTLABELSESSION,						0,	"LabelSession"},
+		{OPTID_OUTSETUPCACHE,						0,	"SetupCache"},
+		{OPTID_OUTSETUPRESET,						0,	"SetupReset"},
+		{OPTID_OUTSETUPTIMEOUT,						0,	"SetupCacheTimeout"},
+		{OPTID_OUTPRINTERPOOL,						0,	"PrinterPool"},
+		{OPTID_OUTSTATUSPOLLING,					0,	"StatusPolling"},
+		{OPTID_OUTCHECKPOINT,						0,	"Checkpoint"},
+		{OPTID_OUTRESUMEJOB,						0,	"ResumeJob"},
+		{OPTID_OUTJOBCACHE,						0,	"JobCache"},
+		{OPTID_OUTJOBCACHESIZE,					0,	"JobCacheSize"},
+		{OPTID_OUTLABELSACROSS,					0,	"LabelsAcross"},
+		{OPTID_OUTLABELCOLUMNGAP,				0,	"LabelColumnGap"},
+		{OPTID_OUTAUTOLENGTH,					0,	"AutoLength"},
+		{OPTID_OUTAUTOLENGTHMARGIN,				0,	"AutoLengthMargin"},
+		{OPTID_OUTADAPTIVESPEED,				0,	"AdaptiveSpeed"},
+		{OPTID_OUTSPEEDMIN,						0,	"AdaptiveSpeedMin"},
+		{OPTID_OUTSPEEDMAX,						0,	"AdaptiveSpeedMax"},
+		{OPTID_OUTASYNCIO,						0,	"AsyncIO"},
+		{OPTID_OUTRASTERMEMORY,					0,	"MaxRasterMemory"},
+		{OPTID_OUTRASTERTIME,					0,	"MaxRasterTime"},
+		{OPTID_OUTBARCODES,						0,	"RecognizeBarcodes"},
+		{OPTID_OUTCUTATEND,						0,	"CutAtJobEnd"},
+		{OPTID_OUTPAGEBOXCLIP,					0,	"PageBoxClip"}
 
 };
 
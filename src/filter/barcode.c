@@ -0,0 +1,603 @@
+/*
+ * "barcode.c 2026-10-17 10:12:40
+ *
+ *  1bpp barcode recognition routines for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+/*
+	Code 128 and EAN symbols printed by the application as dots are found
+	again and sent as BARCODE commands, a few dozen bytes instead of every
+	row.
+
+	One row in BARCODE_SCAN_ROWS is split into runs of black and white.
+	A Code 128 symbol is a start character, its data, the check character
+	and the stop pattern. An EAN-13 or EAN-8 symbol is the guards and its
+	digits, the last one a valid check digit. Every run is a whole number
+	of modules of the same width. The decoded symbol is drawn again as the
+	printer draws it and the rows above and below that are exactly that
+	drawing make the bars. Anything else, a scaled or smeared symbol, text
+	touching the bars or content "128M" cannot carry, stays in the bitmap.
+
+	BARCODE is sent without the human readable line. The digits under an
+	EAN symbol and its guard bars reaching lower are not rows of the whole
+	drawing, they stay in the bitmap as the application printed them.
+*/
+
+#include "config.h"
+#include "common.h"
+#include "barcode.h"
+
+#define	BARCODE_SCAN_ROWS			8		// Rows looked at for symbols, one in
+#define	BARCODE_MIN_HEIGHT			16		// Dots, shorter bars are left as they are
+
+#define	CODE128_FNC3				96
+#define	CODE128_FNC2				97
+#define	CODE128_SHIFT				98
+#define	CODE128_CODE_C				99
+#define	CODE128_CODE_B				100		// FNC4 in code set B
+#define	CODE128_CODE_A				101		// FNC4 in code set A
+#define	CODE128_FNC1				102
+#define	CODE128_START_A				103
+#define	CODE128_START_B				104
+#define	CODE128_START_C				105
+#define	CODE128_STOP				106
+
+// Bar, space, ... widths in modules of the 107 characters
+static const char *g_Code128[CODE128_STOP + 1] = {
+	"212222", "222122", "222221", "121223", "121322", "131222", "122213", "122312",
+	"132212", "221213", "221312", "231212", "112232", "122132", "122231", "113222",
+	"123122", "123221", "223211", "221132", "221231", "213212", "223112", "312131",
+	"311222", "321122", "321221", "312212", "322112", "322211", "212123", "212321",
+	"232121", "111323", "131123", "131321", "112313", "132113", "132311", "211313",
+	"231113", "231311", "112133", "112331", "132131", "113123", "113321", "133121",
+	"313121", "211331", "231131", "213113", "213311", "213131", "311123", "311321",
+	"331121", "312113", "312311", "332111", "314111", "221411", "431111", "111224",
+	"111422", "121124", "121421", "141122", "141221", "112214", "112412", "122114",
+	"122411", "142112", "142211", "241211", "221114", "413111", "241112", "134111",
+	"111242", "121142", "121241", "114212", "124112", "124211", "411212", "421112",
+	"421211", "212141", "214121", "412121", "111143", "111341", "131141", "114113",
+	"114311", "411113", "411311", "113141", "114131", "311141", "411131", "211412",
+	"211214", "211232", "2331112"
+};
+
+// EAN digits as space, bar, space, bar widths in modules, code set A of the
+// left half. Code set B is the same widths reversed, the right half is
+// code set A starting with a bar.
+static const char *g_EanA[10] = {
+	"3211", "2221", "2122", "1411", "1132", "1231", "1114", "1312", "1213", "3112"
+};
+
+// Code sets of the 6 left digits of EAN-13 by its first digit, bit 5 the
+// first of them, 1 = code set B
+static const BYTE g_Ean13Sets[10] = {
+	0x00, 0x0B, 0x0D, 0x0E, 0x13, 0x19, 0x1C, 0x15, 0x16, 0x1A
+};
+
+// Character of 6 widths of 1 to 4 modules, 2 bits each, -1 for none
+static short g_Code128Key[4096];
+static BOOL g_bCode128Key = FALSE;
+
+static void Code128KeyInit(void);
+static unsigned RowRuns(const BYTE *pRow, unsigned nWidth, unsigned *pEdges);
+static BOOL Code128Decode(const unsigned *pEdges, unsigned nEdges, unsigned k, BARCODE *pCode, unsigned *pEnd);
+static BOOL Code128Printable(const BARCODE *pCode);
+static unsigned Code128Draw(const BARCODE *pCode, BYTE *pRow, unsigned nWidth);
+static BOOL EanDecode(const unsigned *pEdges, unsigned nEdges, unsigned k, BARCODE *pCode, unsigned *pEnd);
+static BOOL EanGuard(const unsigned *pEdges, unsigned nRuns, unsigned k, unsigned m, unsigned n);
+static int EanDigit(const unsigned *pEdges, unsigned k, unsigned m, BOOL bRight);
+static int EanCheckDigit(const BARCODE *pCode);
+static unsigned EanDraw(const BARCODE *pCode, BYTE *pRow, unsigned nWidth);
+static unsigned DrawRuns(BYTE *pRow, unsigned x, unsigned nWidth, const char *pszWidths, int bar, unsigned nModule);
+static BOOL RowMatch(const BYTE *pRow, const BYTE *pDraw, unsigned x0, unsigned x1);
+static void RowClear(BYTE *pRow, unsigned x0, unsigned x1);
+
+#define	GETDOT(p, x)				(((p)[(x) >> 3] >> (7 - ((x) & 7))) & 1)
+
+int BarcodeFind(BYTE *pBits, size_t cbRow, unsigned nWidth, unsigned nHeight,
+				BARCODE *pCodes, int nMax)
+{
+	unsigned	*pEdges;
+	BYTE		*pDraw;
+	unsigned	y;
+	int			nCodes = 0;
+
+	if ( nHeight < BARCODE_MIN_HEIGHT || nMax <= 0 )
+		return 0;
+
+	Code128KeyInit();
+
+	pEdges = MEMALLOC(sizeof(unsigned) * (nWidth + 2));
+	pDraw = MEMALLOC(cbRow);
+	if ( pEdges == NULL || pDraw == NULL )
+	{
+		MEMFREE(pEdges);
+		MEMFREE(pDraw);
+		return 0;
+	}
+
+	for (y = BARCODE_SCAN_ROWS / 2; y < nHeight && nCodes < nMax; y += BARCODE_SCAN_ROWS)
+	{
+		unsigned	nEdges = RowRuns(pBits + cbRow * y, nWidth, pEdges);
+		unsigned	k;
+
+		// Odd runs are black
+		for (k = 1; k + 1 < nEdges && nCodes < nMax; k += 2)
+		{
+			BARCODE		*pCode = pCodes + nCodes;
+			unsigned	kEnd;
+			unsigned	x0, x1;
+			unsigned	y0, y1;
+
+			if ( Code128Decode(pEdges, nEdges, k, pCode, &kEnd) && Code128Printable(pCode) )
+				;
+			else if ( !EanDecode(pEdges, nEdges, k, pCode, &kEnd) )
+				continue;
+
+			x0 = pEdges[k];
+			memset(pDraw, 0, cbRow);
+			if ( pCode->type == BARCODE_CODE128 )
+				x1 = Code128Draw(pCode, pDraw, nWidth);
+			else
+				x1 = EanDraw(pCode, pDraw, nWidth);
+			if ( x1 != pEdges[kEnd] || !RowMatch(pBits + cbRow * y, pDraw, x0, x1) )
+				continue;
+
+			for (y0 = y; y0 > 0 && RowMatch(pBits + cbRow * (y0 - 1), pDraw, x0, x1); y0--)
+				;
+			for (y1 = y + 1; y1 < nHeight && RowMatch(pBits + cbRow * y1, pDraw, x0, x1); y1++)
+				;
+			if ( y1 - y0 < BARCODE_MIN_HEIGHT || y1 - y0 > 0xFFFF || x0 > 0xFFFF )
+				continue;
+
+			pCode->y = y0;
+			pCode->height = y1 - y0;
+			for (; y0 < y1; y0++)
+				RowClear(pBits + cbRow * y0, x0, x1);
+			nCodes ++;
+
+			k = kEnd - 1;
+		}
+	}
+
+	MEMFREE(pEdges);
+	MEMFREE(pDraw);
+	return nCodes;
+}
+
+const char* BarcodeType(const BARCODE *pCode)
+{
+	switch ( pCode->type )
+	{
+	case BARCODE_EAN13:
+		return "EAN13";
+	case BARCODE_EAN8:
+		return "EAN8";
+	}
+	return "128M";
+}
+
+void BarcodeData(const BARCODE *pCode, char *szData)
+{
+	int		set = pCode->values[0];
+	char	*p = szData;
+	int		i;
+
+	if ( pCode->type != BARCODE_CODE128 )
+	{
+		for (i=0; i<pCode->count; i++)
+			*p++ = (char)('0' + pCode->values[i]);
+		*p = '\0';
+		return;
+	}
+
+	p += sprintf(p, "!%03d", pCode->values[0]);
+	for (i=1; i<pCode->count; i++)
+	{
+		int		v = pCode->values[i];
+
+		if ( set == CODE128_START_C && v < CODE128_CODE_C )
+			p += sprintf(p, "%02d", v);
+		else if ( set != CODE128_START_C && v < CODE128_FNC3 )
+			*p++ = (char)(' ' + v);
+		else
+		{
+			p += sprintf(p, "!%03d", v);
+			if ( v == CODE128_CODE_C )
+				set = CODE128_START_C;
+			else if ( v == CODE128_CODE_B && set != CODE128_START_B )
+				set = CODE128_START_B;
+			else if ( v == CODE128_CODE_A && set != CODE128_START_A )
+				set = CODE128_START_A;
+		}
+	}
+	*p = '\0';
+}
+
+void Code128KeyInit(void)
+{
+	int		i, j;
+
+	if ( g_bCode128Key )
+		return;
+	for (i=0; i<4096; i++)
+		g_Code128Key[i] = -1;
+	for (i=0; i<CODE128_STOP; i++)
+	{
+		int		key = 0;
+
+		for (j=0; j<6; j++)
+			key = (key << 2) | (g_Code128[i][j] - '1');
+		g_Code128Key[key] = i;
+	}
+	g_bCode128Key = TRUE;
+}
+
+// Edges of the runs of a row, white first: run i is [pEdges[i], pEdges[i + 1]).
+// Returns the number of edges, nWidth is the last one.
+unsigned RowRuns(const BYTE *pRow, unsigned nWidth, unsigned *pEdges)
+{
+	unsigned	nEdges = 0;
+	unsigned	x = 0;
+	int			color = 0;
+
+	pEdges[nEdges++] = 0;
+	while ( x < nWidth )
+	{
+		// Whole bytes of the color of the run
+		if ( (x & 7) == 0 && x + 8 <= nWidth && pRow[x >> 3] == (color ? 0xFF : 0x00) )
+		{
+			x += 8;
+			continue;
+		}
+		if ( GETDOT(pRow, x) != color )
+		{
+			pEdges[nEdges++] = x;
+			color ^= 1;
+		}
+		x ++;
+	}
+	pEdges[nEdges++] = nWidth;
+	return nEdges;
+}
+
+// A symbol whose start character is black run k. *pEnd is the edge after
+// the last bar of the stop pattern.
+BOOL Code128Decode(const unsigned *pEdges, unsigned nEdges, unsigned k, BARCODE *pCode, unsigned *pEnd)
+{
+	unsigned	nRuns = nEdges - 1;
+	unsigned	x = pEdges[k];
+	unsigned	m = 0;
+	unsigned	sum;
+	unsigned	n = 0;
+	unsigned	i;
+	BYTE		values[BARCODE_MAX_VALUES + 1];
+
+	if ( k + 6 > nRuns )
+		return FALSE;
+	m = (pEdges[k + 6] - pEdges[k]) / 11;
+	if ( m == 0 || m > 0xFF || pEdges[k + 6] - pEdges[k] != m * 11 )
+		return FALSE;
+
+	for (;;)
+	{
+		int		key = 0;
+		int		v;
+
+		// The stop pattern, 7 runs
+		if ( n >= 3 && k + 7 <= nRuns )
+		{
+			for (i=0; i<7; i++)
+			{
+				if ( pEdges[k + i + 1] - pEdges[k + i] != (unsigned)(g_Code128[CODE128_STOP][i] - '0') * m )
+					break;
+			}
+			if ( i == 7 )
+				break;
+		}
+
+		if ( k + 6 > nRuns || n > BARCODE_MAX_VALUES )
+			return FALSE;
+		for (i=0; i<6; i++)
+		{
+			unsigned	w = pEdges[k + i + 1] - pEdges[k + i];
+
+			if ( w % m != 0 || w / m < 1 || w / m > 4 )
+				return FALSE;
+			key = (key << 2) | (w / m - 1);
+		}
+		v = g_Code128Key[key];
+		if ( v < 0 || (n == 0) != (v >= CODE128_START_A) )
+			return FALSE;
+		values[n++] = v;
+		k += 6;
+	}
+
+	// Start, data and check character
+	for (sum = values[0], i = 1; i < n - 1; i++)
+		sum += i * values[i];
+	if ( sum % 103 != values[n - 1] )
+		return FALSE;
+
+	memset(pCode, 0, sizeof(BARCODE));
+	pCode->x = x;
+	pCode->narrow = m;
+	pCode->count = n - 1;
+	memcpy(pCode->values, values, n - 1);
+	*pEnd = k + 7;
+	return TRUE;
+}
+
+// Content "128M" sends as it is: no control characters of code set A,
+// no shift and none of the characters the command line quotes or escapes.
+BOOL Code128Printable(const BARCODE *pCode)
+{
+	int		set = pCode->values[0];
+	int		i;
+
+	for (i=1; i<pCode->count; i++)
+	{
+		int		v = pCode->values[i];
+
+		if ( v == CODE128_SHIFT )
+			return FALSE;
+		if ( set == CODE128_START_C )
+		{
+			if ( v == CODE128_CODE_B )
+				set = CODE128_START_B;
+			else if ( v == CODE128_CODE_A )
+				set = CODE128_START_A;
+			continue;
+		}
+		if ( v < CODE128_FNC3 )
+		{
+			// '!', '"', '\\', control characters and DEL
+			if ( v == '!' - ' ' || v == '"' - ' ' || v == '\\' - ' ' )
+				return FALSE;
+			if ( set == CODE128_START_A ? v >= 64 : v >= 95 )
+				return FALSE;
+		}
+		else if ( v == CODE128_CODE_C )
+			set = CODE128_START_C;
+		else if ( v == CODE128_CODE_B && set == CODE128_START_A )
+			set = CODE128_START_B;
+		else if ( v == CODE128_CODE_A && set == CODE128_START_B )
+			set = CODE128_START_A;
+	}
+	return TRUE;
+}
+
+// The symbol as the printer draws it from pCode->x, check character and
+// stop pattern added. Returns the dot after the last bar.
+unsigned Code128Draw(const BARCODE *pCode, BYTE *pRow, unsigned nWidth)
+{
+	unsigned	x = pCode->x;
+	unsigned	sum = pCode->values[0];
+	int			chars[BARCODE_MAX_VALUES + 2];
+	int			n = 0;
+	int			i;
+
+	for (i=0; i<pCode->count; i++)
+	{
+		chars[n++] = pCode->values[i];
+		sum += i * pCode->values[i];
+	}
+	chars[n++] = sum % 103;
+	chars[n++] = CODE128_STOP;
+
+	for (i=0; i<n; i++)
+		x = DrawRuns(pRow, x, nWidth, g_Code128[chars[i]], 1, pCode->narrow);
+	return x;
+}
+
+// An EAN-13 or EAN-8 symbol whose left guard is black run k. *pEnd is the
+// edge after the right guard.
+BOOL EanDecode(const unsigned *pEdges, unsigned nEdges, unsigned k, BARCODE *pCode, unsigned *pEnd)
+{
+	unsigned	nRuns = nEdges - 1;
+	unsigned	m;
+	unsigned	nHalf;
+	unsigned	i, j;
+
+	if ( k + 3 > nRuns )
+		return FALSE;
+	m = pEdges[k + 1] - pEdges[k];
+	if ( m == 0 || m > 0xFF || !EanGuard(pEdges, nRuns, k, m, 3) )
+		return FALSE;
+
+	// 6 digits a half for EAN-13, 4 for EAN-8
+	for (nHalf = 6; nHalf >= 4; nHalf -= 2)
+	{
+		unsigned	kCenter = k + 3 + 4 * nHalf;
+		unsigned	kRight = kCenter + 5 + 4 * nHalf;
+		unsigned	n = nHalf == 6 ? 1 : 0;
+		BYTE		sets = 0;
+		int			d;
+
+		if ( !EanGuard(pEdges, nRuns, kCenter, m, 5) || !EanGuard(pEdges, nRuns, kRight, m, 3) )
+			continue;
+
+		memset(pCode, 0, sizeof(BARCODE));
+		for (i=0; i<nHalf; i++)
+		{
+			if ( (d = EanDigit(pEdges, k + 3 + 4 * i, m, FALSE)) < 0 )
+				break;
+			sets = (sets << 1) | (d >= 10);
+			pCode->values[n++] = d % 10;
+		}
+		for (j=0; i == nHalf && j<nHalf; j++)
+		{
+			if ( (d = EanDigit(pEdges, kCenter + 5 + 4 * j, m, TRUE)) < 0 )
+				break;
+			pCode->values[n++] = d;
+		}
+		if ( i < nHalf || j < nHalf )
+			continue;
+
+		// The code sets of the left half give the first digit of EAN-13
+		if ( nHalf == 6 )
+		{
+			for (d=0; d<10 && g_Ean13Sets[d] != sets; d++)
+				;
+			if ( d == 10 )
+				continue;
+			pCode->values[0] = d;
+			pCode->type = BARCODE_EAN13;
+		}
+		else if ( sets )
+			continue;
+		else
+			pCode->type = BARCODE_EAN8;
+
+		pCode->count = n - 1;
+		if ( EanCheckDigit(pCode) != pCode->values[n - 1] )
+			continue;
+		pCode->values[n - 1] = 0;
+		pCode->x = pEdges[k];
+		pCode->narrow = m;
+		*pEnd = kRight + 3;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+// n runs of one module from run k
+BOOL EanGuard(const unsigned *pEdges, unsigned nRuns, unsigned k, unsigned m, unsigned n)
+{
+	unsigned	i;
+
+	if ( k + n > nRuns )
+		return FALSE;
+	for (i=0; i<n; i++)
+	{
+		if ( pEdges[k + i + 1] - pEdges[k + i] != m )
+			return FALSE;
+	}
+	return TRUE;
+}
+
+// The digit of the 4 runs from run k, 10 more for code set B, -1 for none
+int EanDigit(const unsigned *pEdges, unsigned k, unsigned m, BOOL bRight)
+{
+	char	szWidths[5];
+	int		i;
+
+	for (i=0; i<4; i++)
+	{
+		unsigned	w = pEdges[k + i + 1] - pEdges[k + i];
+
+		if ( w % m != 0 || w / m < 1 || w / m > 4 )
+			return -1;
+		szWidths[i] = '0' + w / m;
+	}
+	szWidths[4] = '\0';
+
+	for (i=0; i<10; i++)
+	{
+		const char	*pszA = g_EanA[i];
+
+		if ( !strcmp(szWidths, pszA) )
+			return i;
+		if ( !bRight && szWidths[0] == pszA[3] && szWidths[1] == pszA[2]
+			&& szWidths[2] == pszA[1] && szWidths[3] == pszA[0] )
+			return 10 + i;
+	}
+	return -1;
+}
+
+// Weights 3, 1, 3, ... from the last digit
+int EanCheckDigit(const BARCODE *pCode)
+{
+	unsigned	sum = 0;
+	int			i;
+
+	for (i=0; i<pCode->count; i++)
+		sum += pCode->values[pCode->count - 1 - i] * (i % 2 ? 1 : 3);
+	return (10 - sum % 10) % 10;
+}
+
+// The symbol as the printer draws it from pCode->x, check digit added.
+// Returns the dot after the last bar.
+unsigned EanDraw(const BARCODE *pCode, BYTE *pRow, unsigned nWidth)
+{
+	unsigned	nHalf = pCode->type == BARCODE_EAN13 ? 6 : 4;
+	const BYTE	*pDigits = pCode->values + (nHalf == 6 ? 1 : 0);
+	BYTE		sets = nHalf == 6 ? g_Ean13Sets[pCode->values[0]] : 0;
+	unsigned	x = pCode->x;
+	unsigned	i;
+
+	x = DrawRuns(pRow, x, nWidth, "111", 1, pCode->narrow);
+	for (i=0; i<nHalf; i++)
+	{
+		const char	*pszA = g_EanA[pDigits[i]];
+		char		szB[5] = { pszA[3], pszA[2], pszA[1], pszA[0], '\0' };
+
+		x = DrawRuns(pRow, x, nWidth, (sets >> (nHalf - 1 - i)) & 1 ? szB : pszA, 0, pCode->narrow);
+	}
+	x = DrawRuns(pRow, x, nWidth, "11111", 0, pCode->narrow);
+	for (i=0; i<nHalf; i++)
+	{
+		int		d = i + 1 < nHalf ? pDigits[nHalf + i] : EanCheckDigit(pCode);
+
+		x = DrawRuns(pRow, x, nWidth, g_EanA[d], 1, pCode->narrow);
+	}
+	return DrawRuns(pRow, x, nWidth, "111", 1, pCode->narrow);
+}
+
+// Runs of the widths in modules from x, the first black if bar.
+// Returns the dot after them.
+unsigned DrawRuns(BYTE *pRow, unsigned x, unsigned nWidth, const char *pszWidths, int bar, unsigned nModule)
+{
+	const char	*p;
+
+	for (p = pszWidths; *p; p++, bar ^= 1)
+	{
+		unsigned	w = (*p - '0') * nModule;
+
+		for (; w > 0 && x < nWidth; w--, x++)
+		{
+			if ( bar )
+				pRow[x >> 3] |= 0x80 >> (x & 7);
+		}
+	}
+	return x;
+}
+
+BOOL RowMatch(const BYTE *pRow, const BYTE *pDraw, unsigned x0, unsigned x1)
+{
+	unsigned	x;
+
+	for (x = x0; x < x1; x++)
+	{
+		if ( (x & 7) == 0 && x + 8 <= x1 )
+		{
+			if ( pRow[x >> 3] != pDraw[x >> 3] )
+				return FALSE;
+			x += 7;
+		}
+		else if ( GETDOT(pRow, x) != GETDOT(pDraw, x) )
+			return FALSE;
+	}
+	return TRUE;
+}
+
+void RowClear(BYTE *pRow, unsigned x0, unsigned x1)
+{
+	unsigned	x;
+
+	for (x = x0; x < x1; x++)
+		pRow[x >> 3] &= ~(0x80 >> (x & 7));
+}
@@ -0,0 +1,61 @@
+/*
+ * "barcode.h 2026-10-17 10:12:40
+ *
+ *  1bpp barcode recognition declaration for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#ifndef _BARCODE_H_
+#define _BARCODE_H_
+
+#include "common.h"
+
+#define	BARCODE_MAX_VALUES			48		// Symbol characters, start included
+#define	BARCODE_MAX_PAGE			32		// Symbols taken from one page
+#define	BARCODE_DATA_LENGTH			(BARCODE_MAX_VALUES * 4 + 1)
+
+// BARCODE.type
+#define	BARCODE_CODE128				0		// Sent as "128M"
+#define	BARCODE_EAN13				1		// Sent as "EAN13", UPC-A is EAN-13 of a leading 0
+#define	BARCODE_EAN8				2		// Sent as "EAN8"
+
+// A symbol found on a page
+typedef struct _BARCODE
+{
+	BYTE		type;					// BARCODE_*
+	WORD		x;						// Dots, left of the start character
+	WORD		y;						// Dots, top of the bars
+	WORD		height;					// Dots
+	BYTE		narrow;					// Dots, module width
+	BYTE		count;					// values[], no check character and stop
+	BYTE		values[BARCODE_MAX_VALUES];		// Symbol characters, digits of EAN
+} BARCODE;
+
+// Finds the Code 128 and EAN symbols of the nWidth x nHeight page, set bit = black,
+// that the printer draws dot for dot the same, and clears them from pBits.
+// Returns the number of symbols put to pCodes.
+int			BarcodeFind(BYTE *pBits, size_t cbRow, unsigned nWidth, unsigned nHeight,
+						BARCODE *pCodes, int nMax);
+
+// The BARCODE type of a symbol
+const char*	BarcodeType(const BARCODE *pCode);
+
+// The content of a symbol: for "128M" its characters with ! escapes for
+// the start, code set and function characters, for EAN the digits
+// without the check digit
+void		BarcodeData(const BARCODE *pCode, char *szData);
+
+#endif	// #ifndef _BARCODE_H_
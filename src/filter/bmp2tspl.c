@@ -22,6 +22,8 @@
 #include "debug.h"
 #include "devmode.h"
 #include "device.h"
+#include "jobcache.h"
+#include "probe.h"
 
 static size_t ReadPipe(int fd, void* buffer, size_t size);
 static size_t SkipPipe(int fd, size_t size);
@@ -36,6 +38,8 @@ int bmp2tspl(int fdIn)
 	BITMAPINFOHEADER	biHeader;
 	RGBQUAD				*pColorTable = NULL;
 	LPVOID				pBits = NULL;
+	const PAGEBOX		*pBoxes = NULL;		// Page placements from ps2bmp
+	DWORD				nBoxes = 0;
 
 	DebugPrintf("Enter bmp2tspl\n");
 
@@ -58,6 +62,21 @@ int bmp2tspl(int fdIn)
 
 	pdm->dmOutPages = 0;
 
+	if ( iRtn > 0 && pdm->dmJobCacheHit )
+	{
+		iRtn = JobCacheSend(pdm, fileno(stdout)) ? 0 : -1;
+		MEMFREE(pdm);
+		return iRtn;
+	}
+	if ( iRtn > 0 && pdm->dmJobCacheKey[0] )
+		JobCacheRecord(pdm);
+
+	if ( iRtn > 0 )
+	{
+		pBoxes = (const PAGEBOX *)(pdm + 1);
+		nBoxes = pdm->dmSizeExtra / sizeof(PAGEBOX);
+	}
+
 	for ( ; iRtn > 0 ;)
 	{
 		iRtn = ReadBitmapData(fdIn, &bmfHeader, &biHeader, &pColorTable, &pBits);
@@ -69,12 +88,30 @@ int bmp2tspl(int fdIn)
 		}
 		else if ( iRtn > 0 )
 		{
+			int		x = 0;
+			int		y = 0;
+
+			TSC_PROBE4(gs__page, pdm->dmOutPages + 1, biHeader.biWidth, biHeader.biHeight, biHeader.biSizeImage);
+
+			// A page rendered for its bounding box goes where the box is
+			if ( pdm->dmDocPages && pdm->dmOutPages % pdm->dmDocPages < nBoxes )
+			{
+				const PAGEBOX	*pbox = pBoxes + pdm->dmOutPages % pdm->dmDocPages;
+
+				if ( pbox->right > pbox->left )
+				{
+					x = (int)(POINT2DOT((double)pbox->left, pdm->dmPrintQuality) + 0.5);
+					y = (int)(POINT2DOT((double)pdm->dmPaperLength - pbox->top, pdm->dmYResolution) + 0.5);
+				}
+			}
+
 			// Send Page
-			TSPL_SendPage(pdm, &biHeader, pColorTable, pBits);
+			TSPL_SendPage(pdm, x, y, &biHeader, pColorTable, pBits);
 		}
 		MEMFREE(pColorTable);
 		MEMFREE(pBits);
 	}
+	JobCacheCommit(iRtn == 0);
 	MEMFREE(pdm);
 
 	DebugPrintf("Leave bmp2tspl, return %d\n", iRtn);
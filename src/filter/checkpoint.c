@@ -0,0 +1,152 @@
+/*
+ * "checkpoint.c 2026-10-17 10:12:40
+ *
+ *  job checkpoint routines for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+/*
+	One small text file per job, replaced after every label:
+
+		TSCCKPT <pages> <copies> <collate> <labels done>
+
+	A new file is written next to it and renamed over it, so a crash leaves
+	the last count and never an empty file. The file is removed when the
+	job completes, so a file that is left behind belongs to a job that
+	failed or was cancelled.
+*/
+
+#include "config.h"
+#include "common.h"
+#include "debug.h"
+#include "checkpoint.h"
+
+typedef struct _CHECKPOINTFILE
+{
+	BOOL		bOpen;
+	CHECKPOINT	ckpt;
+	char		szFile[256];
+} CHECKPOINTFILE;
+
+static CHECKPOINTFILE	g_ckpt;
+
+static BOOL CheckpointWrite(void);
+static void CheckpointFileName(DEVDATA *pdev, DWORD dwJobId, char *szFile, size_t size);
+
+BOOL CheckpointLoad(DEVDATA *pdev, DWORD dwJobId, CHECKPOINT *pckpt)
+{
+	FILE			*fp;
+	char			szFile[256];
+	unsigned		pages, copies, collate, done;
+	BOOL			bRtn = FALSE;
+
+	CheckpointFileName(pdev, dwJobId, szFile, sizeof(szFile));
+	if ( (fp = fopen(szFile, "r")) == NULL )
+		return FALSE;
+
+	if ( fscanf(fp, CHECKPOINT_MARKER " %u %u %u %u", &pages, &copies, &collate, &done) == 4 )
+	{
+		pckpt->dwPages  = pages;
+		pckpt->dwCopies = copies;
+		pckpt->wCollate = collate;
+		pckpt->dwDone   = done;
+		bRtn = TRUE;
+	}
+	fclose(fp);
+
+	DebugPrintf("CheckpointLoad: %s, %u labels done\n", szFile, bRtn ? done : 0);
+	return bRtn;
+}
+
+// The checkpoint of the job starts at dwDone labels, as a resumed job
+BOOL CheckpointOpen(DEVDATA *pdev, DWORD dwJobId, DWORD dwDone)
+{
+	CheckpointFileName(pdev, dwJobId, g_ckpt.szFile, sizeof(g_ckpt.szFile));
+
+	g_ckpt.ckpt.dwPages  = pdev->dm.dmDocPages;
+	g_ckpt.ckpt.dwCopies = pdev->dm.dmCopies;
+	g_ckpt.ckpt.wCollate = pdev->dm.dmCollate ? 1 : 0;
+	g_ckpt.ckpt.dwDone   = dwDone;
+
+	g_ckpt.bOpen = CheckpointWrite();
+	if ( !g_ckpt.bOpen )
+		Error_Log(LEVEL_WARNING, "Unable to create checkpoint %s - %s\n", g_ckpt.szFile, strerror(errno));
+	return g_ckpt.bOpen;
+}
+
+void CheckpointUpdate(DWORD dwDone)
+{
+	if ( !g_ckpt.bOpen || dwDone == g_ckpt.ckpt.dwDone )
+		return;
+
+	g_ckpt.ckpt.dwDone = dwDone;
+	if ( !CheckpointWrite() )
+		DebugPrintf("CheckpointUpdate: %s\n", strerror(errno));
+}
+
+void CheckpointClose(BOOL bComplete)
+{
+	if ( !g_ckpt.bOpen )
+		return;
+
+	g_ckpt.bOpen = FALSE;
+	if ( bComplete )
+		unlink(g_ckpt.szFile);
+}
+
+void CheckpointRemove(DEVDATA *pdev, DWORD dwJobId)
+{
+	char	szFile[256];
+
+	CheckpointFileName(pdev, dwJobId, szFile, sizeof(szFile));
+	unlink(szFile);
+}
+
+BOOL CheckpointWrite(void)
+{
+	FILE	*fp;
+	char	szTemp[sizeof(g_ckpt.szFile) + 16];
+
+	snprintf(szTemp, sizeof(szTemp), "%s.%d", g_ckpt.szFile, (int)getpid());
+	if ( (fp = fopen(szTemp, "w")) == NULL )
+		return FALSE;
+
+	fprintf(fp, CHECKPOINT_MARKER " %u %u %u %u\n",
+			g_ckpt.ckpt.dwPages, g_ckpt.ckpt.dwCopies, g_ckpt.ckpt.wCollate, g_ckpt.ckpt.dwDone);
+
+	if ( fclose(fp) || rename(szTemp, g_ckpt.szFile) )
+	{
+		unlink(szTemp);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+void CheckpointFileName(DEVDATA *pdev, DWORD dwJobId, char *szFile, size_t size)
+{
+	const char	*szDir;
+	char		*p;
+
+	if ( (szDir = getenv("CUPS_CACHEDIR")) == NULL )
+		szDir = CHECKPOINT_DIR;
+
+	snprintf(szFile, size, CHECKPOINT_FILE, szDir, pdev->szPrinterName, dwJobId);
+	for (p = szFile + strlen(szDir) + 1; *p; p++)
+	{
+		if ( *p == '/' )
+			*p = '_';
+	}
+}
@@ -0,0 +1,44 @@
+/*
+ * "checkpoint.h 2026-10-17 10:12:40
+ *
+ *  job checkpoint declaration for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_
+
+#include "device.h"
+
+#define	CHECKPOINT_DIR				"/var/cache/cups"
+#define	CHECKPOINT_FILE				"%s/tsc-%s-%u.ckpt"		// by cache dir, printer name, job id
+#define	CHECKPOINT_MARKER			"TSCCKPT"
+
+typedef struct _CHECKPOINT
+{
+	DWORD	dwPages;				// Pages of the document
+	DWORD	dwCopies;
+	WORD	wCollate;
+	DWORD	dwDone;					// Labels printed, in job order
+} CHECKPOINT;
+
+BOOL	CheckpointLoad(DEVDATA *pdev, DWORD dwJobId, CHECKPOINT *pckpt);
+BOOL	CheckpointOpen(DEVDATA *pdev, DWORD dwJobId, DWORD dwDone);
+void	CheckpointUpdate(DWORD dwDone);
+void	CheckpointClose(BOOL bComplete);
+void	CheckpointRemove(DEVDATA *pdev, DWORD dwJobId);
+
+#endif	// #ifndef _CHECKPOINT_H_
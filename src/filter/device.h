@@ -62,6 +62,19 @@ typedef struct tagRGBQUAD {
 } RGBQUAD, *PRGBQUAD;
 #pragma pack()
 
+// Inked area of a page from its %%PageBoundingBox, in points from the lower
+// left corner. The DEVMODE piped to bmp2tspl is followed by one per document
+// page when dmSizeExtra is set; a page with an empty box was rendered whole.
+typedef struct _PAGEBOX
+{
+	SHORT	left;
+	SHORT	bottom;
+	SHORT	right;
+	SHORT	top;
+} PAGEBOX;
+
+#define	PAGEBOX_MAX				(0xFFFF / sizeof(PAGEBOX))
+
 typedef struct _GSDATA
 {
 	void			*gsInstance;
@@ -93,7 +106,7 @@ typedef struct _DEVDATA
 int ps2bmp(int argc, char *argv[]);
 int bmp2tspl(int fdIn);
 
-int TSPL_SendPage(DEVMODE *pdm, BITMAPINFOHEADER* pBih, RGBQUAD *pColorTable, void* pBits);
+int TSPL_SendPage(DEVMODE *pdm, int x, int y, BITMAPINFOHEADER* pBih, RGBQUAD *pColorTable, void* pBits);
 int TSPL_SendJobEnd(DEVMODE *pdm);
 
 #endif	// #ifndef _DEVICE_H_
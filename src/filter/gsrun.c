@@ -57,7 +57,7 @@ int gsrun(DEVDATA *pdev)
 
 #ifdef FILTER_NOT_PSTOPS
 
-		OutputDevmode(pdev);
+		OutputDevmode(pdev, NULL, 0);
 		do
 		{
 			if ( ! gs_write(pdev, line, len) )
@@ -226,16 +226,18 @@ BOOL gsClose(DEVDATA *pdev)
 #endif	// #ifndef FILTER_NOT_PS2BMP
 }
 
-BOOL OutputDevmode(DEVDATA *pdev)
+BOOL OutputDevmode(DEVDATA *pdev, const PAGEBOX *pBoxes, int nBoxes)
 {
 	BOOL				bRtn = TRUE;
 #if defined(FILTER_NOT_PS2BMP) || defined(FILTER_NOT_BMP2TSPL)
 #else
 	pdev->dm.dmType = DM_HEADER_MARKER;
 	pdev->dm.dmSize = sizeof(pdev->dm);
-	pdev->dm.dmSizeExtra = 0;
+	pdev->dm.dmSizeExtra = pBoxes ? sizeof(PAGEBOX) * min(nBoxes, PAGEBOX_MAX) : 0;
 
 	bRtn = fwrite(&pdev->dm, 1, sizeof(pdev->dm), stdout) > 0;
+	if ( bRtn && pdev->dm.dmSizeExtra )
+		bRtn = fwrite(pBoxes, 1, pdev->dm.dmSizeExtra, stdout) > 0;
 #endif
 	return bRtn;
 }
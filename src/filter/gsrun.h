@@ -24,7 +24,7 @@
 int gsrun(DEVDATA *pdev);
 int psrun(DEVDATA *pdev, char *line, size_t linelen, size_t linesize);
 
-BOOL OutputDevmode(DEVDATA *pdev);
+BOOL OutputDevmode(DEVDATA *pdev, const PAGEBOX *pBoxes, int nBoxes);
 
 BOOL gs_write(DEVDATA *pdev, const char *s, size_t len);
 BOOL gs_putchar(DEVDATA *pdev, char c);
@@ -0,0 +1,346 @@
+/*
+ * "jobcache.c 2026-10-17 10:12:40
+ *
+ *  job output cache routines for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+/*
+	The printer output of a job is kept under the SHA-256 of the document
+	bytes, the DEVMODE it was printed with and the driver VERSION. A
+	reprint with the same key sends the cached file as is, nothing is
+	decoded or rasterized.
+
+	A cached stream is replayed without knowing what the printer was set
+	up for, so it is recorded with the full job setup. The oldest files,
+	by last use, are removed when the cache grows over dmJobCacheSize MB.
+*/
+
+#include "config.h"
+#include "common.h"
+#include "debug.h"
+#include "netio.h"
+#include "sha256.h"
+#include "jobcache.h"
+
+#include <dirent.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+#define	JOBCACHE_BUFFER				65536
+
+typedef struct _CACHEENTRY
+{
+	char		szName[DM_JOBCACHEKEY_LENGTH + 8];
+	off_t		size;
+	time_t		tUsed;
+} CACHEENTRY;
+
+typedef struct _JOBCACHE
+{
+	int			fdRecord;				// Output recorded for the cache
+	int			fdHit;					// Cached output to send
+	DWORD		dwLimit;				// MB
+	char		szDir[256];
+	char		szFile[256 + DM_JOBCACHEKEY_LENGTH + 8];
+	char		szTemp[256 + DM_JOBCACHEKEY_LENGTH + 24];
+} JOBCACHE;
+
+static JOBCACHE		g_cache = { -1, -1 };
+
+int TSPL_SetupStateReset(DEVMODE *pdm);
+
+static int JobCacheSpool(int fdIn, SHA256_CTX *ctx);
+static void JobCacheFileName(DEVMODE *pdm);
+static void JobCacheEvict(void);
+static int CompareEntry(const void *p1, const void *p2);
+
+// Hash the document read from fdIn with the settings of pdm.
+// Returns the descriptor to read the document from, at its start again.
+int JobCacheLookup(DEVMODE *pdm, int fdIn)
+{
+	SHA256_CTX		ctx;
+	DEVMODE			dm;
+	BYTE			digest[SHA256_DIGEST_LENGTH];
+	int				fdDoc;
+
+	memset(pdm->dmJobCacheKey, 0, sizeof(pdm->dmJobCacheKey));
+	pdm->dmJobCacheHit = FALSE;
+
+	Sha256Init(&ctx);
+	if ( (fdDoc = JobCacheSpool(fdIn, &ctx)) < 0 )
+		return fdDoc;
+
+	// Settings that do not change the output
+	memcpy(&dm, pdm, sizeof(DEVMODE));
+	dm.dmSetupCache = 0;
+	dm.dmSetupReset = 0;
+	dm.dmSetupTimeout = 0;
+	dm.dmStatusPolling = 0;
+	dm.dmCheckpoint = 0;
+	dm.dmResumeJob = 0;
+	dm.dmJobCacheSize = 0;
+	dm.dmAsyncIO = 0;
+	dm.dmRasterMemory = 0;
+	dm.dmRasterTime = 0;
+	Sha256Update(&ctx, &dm, sizeof(DEVMODE));
+
+	// Another driver version may encode the same job another way
+	Sha256Update(&ctx, VERSION, strlen(VERSION));
+
+	Sha256Final(&ctx, digest);
+	Sha256String(digest, pdm->dmJobCacheKey);
+	JobCacheFileName(pdm);
+
+	if ( (g_cache.fdHit = open(g_cache.szFile, O_RDONLY)) >= 0 )
+	{
+		// Most recently used, and not evicted before it is sent
+		utime(g_cache.szFile, NULL);
+		pdm->dmJobCacheHit = TRUE;
+	}
+
+	DebugPrintf("JobCacheLookup: %s %s\n", pdm->dmJobCacheKey, pdm->dmJobCacheHit ? "hit" : "miss");
+	return fdDoc;
+}
+
+BOOL JobCacheSend(DEVMODE *pdm, int fdOut)
+{
+	struct stat		st;
+	BOOL			bRtn = FALSE;
+
+	if ( g_cache.fdHit < 0 )
+	{
+		JobCacheFileName(pdm);
+		g_cache.fdHit = open(g_cache.szFile, O_RDONLY);
+	}
+	if ( g_cache.fdHit < 0 || fstat(g_cache.fdHit, &st) )
+	{
+		Error_Log(LEVEL_ERROR, "Unable to open cached job %s - %s\n", g_cache.szFile, strerror(errno));
+		return FALSE;
+	}
+
+	if ( NetSendFile(fdOut, g_cache.fdHit, 0, st.st_size) == st.st_size )
+	{
+		Error_Log(LEVEL_INFO, "Job sent from output cache, %ld KB\n", (long)(st.st_size / 1024));
+		bRtn = TRUE;
+	}
+	else
+		Error_Log(LEVEL_ERROR, "IO error: %s\n", strerror(errno));
+
+	close(g_cache.fdHit);
+	g_cache.fdHit = -1;
+
+	// The printer has the setup of the cached job now, not the saved one
+	TSPL_SetupStateReset(pdm);
+	return bRtn;
+}
+
+BOOL JobCacheRecord(DEVMODE *pdm)
+{
+	if ( pdm->dmJobCacheKey[0] == 0 )
+		return FALSE;
+
+	JobCacheFileName(pdm);
+	g_cache.dwLimit = pdm->dmJobCacheSize ? pdm->dmJobCacheSize : JOBCACHESIZE_DEF_VALUE;
+
+	if ( mkdir(g_cache.szDir, 0700) && errno != EEXIST )
+	{
+		Error_Log(LEVEL_WARNING, "Unable to create output cache %s - %s\n", g_cache.szDir, strerror(errno));
+		return FALSE;
+	}
+
+	snprintf(g_cache.szTemp, sizeof(g_cache.szTemp), "%s.%d", g_cache.szFile, (int)getpid());
+	if ( (g_cache.fdRecord = open(g_cache.szTemp, O_WRONLY | O_CREAT | O_TRUNC, 0600)) < 0 )
+	{
+		Error_Log(LEVEL_WARNING, "Unable to create %s - %s\n", g_cache.szTemp, strerror(errno));
+		return FALSE;
+	}
+
+	pdm->dmSetupReset = TRUE;
+	return TRUE;
+}
+
+void JobCacheWrite(const void *pbuf, size_t cbbuf)
+{
+	if ( g_cache.fdRecord < 0 )
+		return;
+
+	if ( NetWriteAll(g_cache.fdRecord, pbuf, cbbuf) != cbbuf )
+	{
+		DebugPrintf("JobCacheWrite: %s\n", strerror(errno));
+		close(g_cache.fdRecord);
+		g_cache.fdRecord = -1;
+		unlink(g_cache.szTemp);
+	}
+}
+
+void JobCacheWriteFile(int fdIn, off_t offset, size_t count)
+{
+	char		buffer[JOBCACHE_BUFFER];
+	ssize_t		nBytes;
+
+	while ( g_cache.fdRecord >= 0 && count > 0 )
+	{
+		if ( (nBytes = pread(fdIn, buffer, min(count, sizeof(buffer)), offset)) <= 0 )
+		{
+			if ( nBytes < 0 && errno == EINTR )
+				continue;
+			JobCacheCommit(FALSE);
+			break;
+		}
+		JobCacheWrite(buffer, nBytes);
+		offset += nBytes;
+		count -= nBytes;
+	}
+}
+
+void JobCacheCommit(BOOL bComplete)
+{
+	if ( g_cache.fdRecord < 0 )
+		return;
+
+	if ( close(g_cache.fdRecord) == 0 && bComplete && rename(g_cache.szTemp, g_cache.szFile) == 0 )
+	{
+		DebugPrintf("JobCacheCommit: %s\n", g_cache.szFile);
+		JobCacheEvict();
+	}
+	else
+		unlink(g_cache.szTemp);
+	g_cache.fdRecord = -1;
+}
+
+// A pipe is copied to an unlinked spool file, a file is read in place.
+int JobCacheSpool(int fdIn, SHA256_CTX *ctx)
+{
+	char			buffer[JOBCACHE_BUFFER];
+	char			szSpool[256];
+	const char		*szDir;
+	struct stat		st;
+	off_t			start = 0;
+	ssize_t			nBytes;
+	int				fdDoc = fdIn;
+
+	if ( fstat(fdIn, &st) == 0 && S_ISREG(st.st_mode) )
+		start = lseek(fdIn, 0, SEEK_CUR);
+	else
+	{
+		if ( (szDir = getenv("TMPDIR")) == NULL )
+			szDir = JOBCACHE_SPOOL_DIR;
+		snprintf(szSpool, sizeof(szSpool), "%s/tsc-spool.XXXXXX", szDir);
+		if ( (fdDoc = mkstemp(szSpool)) < 0 )
+		{
+			Error_Log(LEVEL_WARNING, "Unable to create %s, output cache off - %s\n", szSpool, strerror(errno));
+			return fdIn;
+		}
+		unlink(szSpool);
+	}
+
+	while ( (nBytes = read(fdIn, buffer, sizeof(buffer))) != 0 )
+	{
+		if ( nBytes < 0 && errno == EINTR )
+			continue;
+		if ( nBytes < 0 || (fdDoc != fdIn && NetWriteAll(fdDoc, buffer, nBytes) != nBytes) )
+		{
+			// The document is gone with the pipe
+			Error_Log(LEVEL_ERROR, "Unable to spool print file - %s\n", strerror(errno));
+			if ( fdDoc != fdIn )
+				close(fdDoc);
+			return -1;
+		}
+		Sha256Update(ctx, buffer, nBytes);
+	}
+
+	lseek(fdDoc, start, SEEK_SET);
+	return fdDoc;
+}
+
+void JobCacheFileName(DEVMODE *pdm)
+{
+	const char	*szDir;
+
+	if ( (szDir = getenv("CUPS_CACHEDIR")) == NULL )
+		szDir = JOBCACHE_DIR;
+
+	snprintf(g_cache.szDir, sizeof(g_cache.szDir), JOBCACHE_SUBDIR, szDir);
+	snprintf(g_cache.szFile, sizeof(g_cache.szFile), JOBCACHE_FILE, g_cache.szDir, pdm->dmJobCacheKey);
+}
+
+void JobCacheEvict(void)
+{
+	DIR				*dir;
+	struct dirent	*entry;
+	struct stat		st;
+	char			szPath[sizeof(g_cache.szFile)];
+	CACHEENTRY		*entries = NULL;
+	int				nEntries = 0;
+	int				nAlloc = 0;
+	double			dTotal = 0;
+	double			dLimit = (double)g_cache.dwLimit * 1024 * 1024;
+	int				i;
+
+	if ( (dir = opendir(g_cache.szDir)) == NULL )
+		return;
+
+	while ( (entry = readdir(dir)) != NULL )
+	{
+		size_t	len = strlen(entry->d_name);
+
+		// Files being recorded end in their pid
+		if ( len <= 5 || len >= sizeof(entries->szName) || strcmp(entry->d_name + len - 5, ".tspl") )
+			continue;
+		snprintf(szPath, sizeof(szPath), "%s/%s", g_cache.szDir, entry->d_name);
+		if ( stat(szPath, &st) )
+			continue;
+
+		if ( nEntries == nAlloc )
+		{
+			CACHEENTRY	*p = realloc(entries, (nAlloc ? nAlloc * 2 : 64) * sizeof(CACHEENTRY));
+
+			if ( p == NULL )
+				break;
+			entries = p;
+			nAlloc = nAlloc ? nAlloc * 2 : 64;
+		}
+		strcpy(entries[nEntries].szName, entry->d_name);
+		entries[nEntries].size = st.st_size;
+		entries[nEntries].tUsed = st.st_mtime;
+		dTotal += st.st_size;
+		nEntries ++;
+	}
+	closedir(dir);
+
+	if ( dTotal > dLimit )
+	{
+		qsort(entries, nEntries, sizeof(CACHEENTRY), CompareEntry);
+		for (i=0; i<nEntries && dTotal > dLimit; i++)
+		{
+			snprintf(szPath, sizeof(szPath), "%s/%s", g_cache.szDir, entries[i].szName);
+			if ( unlink(szPath) == 0 )
+				dTotal -= entries[i].size;
+			DebugPrintf("JobCacheEvict: %s\n", szPath);
+		}
+	}
+	free(entries);
+}
+
+// Least recently used first
+int CompareEntry(const void *p1, const void *p2)
+{
+	time_t	t1 = ((const CACHEENTRY*)p1)->tUsed;
+	time_t	t2 = ((const CACHEENTRY*)p2)->tUsed;
+
+	return t1 < t2 ? -1 : t1 > t2 ? 1 : 0;
+}
@@ -0,0 +1,38 @@
+/*
+ * "jobcache.h 2026-10-17 10:12:40
+ *
+ *  job output cache declaration for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#ifndef _JOBCACHE_H_
+#define _JOBCACHE_H_
+
+#include "devmode.h"
+
+#define	JOBCACHE_DIR				"/var/cache/cups"
+#define	JOBCACHE_SUBDIR				"%s/tsc-jobcache"		// by cache dir
+#define	JOBCACHE_FILE				"%s/%s.tspl"			// by cache subdir, key
+#define	JOBCACHE_SPOOL_DIR			"/tmp"
+
+int		JobCacheLookup(DEVMODE *pdm, int fdIn);
+BOOL	JobCacheSend(DEVMODE *pdm, int fdOut);
+BOOL	JobCacheRecord(DEVMODE *pdm);
+void	JobCacheWrite(const void *pbuf, size_t cbbuf);
+void	JobCacheWriteFile(int fdIn, off_t offset, size_t count);
+void	JobCacheCommit(BOOL bComplete);
+
+#endif	// #ifndef _JOBCACHE_H_
@@ -25,6 +25,7 @@
 #include "devmode.h"
 #include "device.h"
 #include "gsrun.h"
+#include "jobcache.h"
 
 #define		GSDEVICE_BMP_MONO	"bmpmono"
 #define		GSDEVICE_BMP_GRAY	"bmpgray"
@@ -32,6 +33,7 @@
 static DEVDATA* DrvEnable(int argc, char *argv[]);
 static void DrvDisable(DEVDATA *pdev);
 static BOOL bInitCupsOptions(DEVDATA *pdev, char *argv[]);
+static BOOL JobCacheOpen(DEVDATA *pdev, int argc, char *argv[]);
 
 int ps2bmp(int argc, char *argv[])
 {
@@ -44,7 +46,15 @@ int ps2bmp(int argc, char *argv[])
 
 	pdev = DrvEnable(argc, argv);
 
-	iRtn = gsrun(pdev);
+	if ( pdev && pdev->dm.dmJobCache == DMJOBCACHE_ON && !JobCacheOpen(pdev, argc, argv) )
+		iRtn = -1;
+	else if ( pdev && pdev->dm.dmJobCacheHit )
+	{
+		// bmp2tspl sends the cached output
+		iRtn = OutputDevmode(pdev, NULL, 0) ? 0 : -1;
+	}
+	else
+		iRtn = gsrun(pdev);
 	
 	DrvDisable(pdev);
 	DebugPrintf("Leave ps2bmp, return %d\n", iRtn);
@@ -52,6 +62,35 @@ int ps2bmp(int argc, char *argv[])
 	return iRtn;
 }
 
+// Look the job up in the output cache, the key goes to bmp2tspl with the DEVMODE.
+BOOL JobCacheOpen(DEVDATA *pdev, int argc, char *argv[])
+{
+	int			fdIn;
+	int			fdDoc;
+	cups_file_t	*fp;
+
+	fdIn = (argc == 7) ? open(argv[6], O_RDONLY) : dup(0);
+	if ( fdIn < 0 )
+		return TRUE;
+
+	if ( (fdDoc = JobCacheLookup(&pdev->dm, fdIn)) < 0 )
+	{
+		close(fdIn);
+		return FALSE;
+	}
+	if ( fdDoc != fdIn )
+		close(fdIn);
+
+	if ( (fp = pdev->lib_cups.cupsFileOpenFd(fdDoc, "r")) == NULL )
+	{
+		close(fdDoc);
+		return FALSE;
+	}
+	pdev->lib_cups.cupsFileClose(pdev->fpPS);
+	pdev->fpPS = fp;
+	return TRUE;
+}
+
 DEVDATA* DrvEnable(int argc, char *argv[])
 {
 	DEVDATA*	pdev = NULL;
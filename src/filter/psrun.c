@@ -75,6 +75,8 @@ static ssize_t copy_setup(DEVDATA *pdev, pstops_doc_t *doc, char *line, ssize_t
 static ssize_t copy_page(DEVDATA *pdev, pstops_doc_t *doc, char *line, ssize_t linelen, size_t linesize);
 static ssize_t copy_trailer(DEVDATA *pdev, pstops_doc_t *doc, char *line, ssize_t linelen, size_t linesize);
 
+static void parse_bounding_box(const char *s, int bounding_box[4]);
+static BOOL page_box(DEVDATA *pdev, const pstops_page_t *pageinfo, PAGEBOX *pbox);
 static char * parse_text(const char	*start, char **end, char *buffer, size_t bufsize);
 static pstops_page_t *add_page(DEVDATA *pdev, pstops_doc_t *doc, const char *label);
 
@@ -190,6 +192,10 @@ void copy_dsc(
 			int			i;
 			int			nCopies;
 			int			nDriverCoyies = 1;		// Collection Copies
+			PAGEBOX		*pBoxes;
+			int			nBoxes;
+			BOOL		bClip = FALSE;			// Any page is clipped
+			BOOL		bClipped = FALSE;		// The device is set up for a clip
 
 			pdev->dm.dmDocPages = number;
 			pdev->dm.dmCollate = 0;
@@ -198,10 +204,31 @@ void copy_dsc(
 				pdev->dm.dmCollate = 1;
 				nDriverCoyies = pdev->dm.dmCopies;
 			}
-			OutputDevmode(pdev);
+
+			// With PageBoxClip, pages with a %%PageBoundingBox are rendered for
+			// their inked area only, bmp2tspl places them with the boxes sent
+			// here. Without it the document goes to Ghostscript as it is.
+			nBoxes = min(number, PAGEBOX_MAX);
+			pBoxes = NULL;
+			if ( pdev->dm.dmPageBoxClip == DMPAGEBOXCLIP_ON )
+				pBoxes = MEMALLOC(sizeof(PAGEBOX) * nBoxes);
+			for(i=0; pBoxes && i<nBoxes; i++)
+			{
+				pageinfo = (pstops_page_t *)pdev->lib_cups.cupsArrayIndex(doc->pages, i);
+				if ( pageinfo && page_box(pdev, pageinfo, pBoxes + i) )
+					bClip = TRUE;
+			}
+			OutputDevmode(pdev, bClip ? pBoxes : NULL, nBoxes);
 
 			DebugPrintf("  nDriverCoyies = %d, dmDocPages = %d\n", nDriverCoyies, number);
 
+			if ( bClip )
+			{
+				// Keep what the document set up, to go back to for whole pages
+				gs_puts(pdev, "userdict /TSCPageSize currentpagedevice /PageSize get put\n");
+				gs_puts(pdev, "userdict /TSCInstall currentpagedevice /Install get put\n");
+			}
+
 			for ( nCopies=0; nCopies<nDriverCoyies; nCopies++ )
 			{
 				for(i=0; i<number; i++)
@@ -210,9 +237,24 @@ void copy_dsc(
 
 					if ( pageinfo )
 					{
+						PAGEBOX		*pbox = (bClip && i < nBoxes) ? pBoxes + i : NULL;
+
 						doc->total_page ++;
 						gs_printf(pdev, "%%%%Page: %s %d\n", pageinfo->label, doc->total_page);
 
+						if ( pbox && pbox->right > pbox->left )
+						{
+							// A page the size of the box, moved so the box lands on it
+							gs_printf(pdev, "<< /PageSize [%d %d] /Install { TSCInstall %d %d translate } bind >> setpagedevice\n",
+								pbox->right - pbox->left, pbox->top - pbox->bottom, -pbox->left, -pbox->bottom);
+							bClipped = TRUE;
+						}
+						else if ( bClipped )
+						{
+							gs_puts(pdev, "<< /PageSize TSCPageSize /Install /TSCInstall load >> setpagedevice\n");
+							bClipped = FALSE;
+						}
+
 						copy_bytes(pdev, doc->fp_temp, pageinfo->offset, pageinfo->length);
 					}
 					else
@@ -221,6 +263,7 @@ void copy_dsc(
 					}
 				}
 			}
+			MEMFREE(pBoxes);
 		}
 	}
 
@@ -403,7 +446,6 @@ ssize_t	copy_page(
 	int		level;				/* Embedded document level */
 	pstops_page_t	*pageinfo;		/* Page information */
 	int		first_page;			/* First page on N-up output? */
-	int		bounding_box[4];	/* PageBoundingBox */
 	int		number;
 
 	DebugPrintf("#Enter copy_page(), Page = %d\n", doc->total_page);
@@ -422,25 +464,12 @@ ssize_t	copy_page(
 
 	pageinfo = add_page(pdev, doc, label);
 
-//	memcpy(bounding_box, doc->bounding_box, sizeof(bounding_box));
 	while ((linelen = pdev->lib_cups.cupsFileGetLine(pdev->fpPS, line, linesize)) > 0)
 	{
 		if (!strncmp(line, "%%PageBoundingBox:", 18))
 		{
 			// %%PageBoundingBox: llx lly urx ury
-//			if (sscanf(line + 18, "%d%d%d%d", bounding_box + 0,
-//				bounding_box + 1, bounding_box + 2,
-//				bounding_box + 3) != 4)
-//			{
-//				memcpy(bounding_box, doc->bounding_box, sizeof(bounding_box));
-//				DebugPrintf("Get PageBoundingBox ERROR!\n");
-//			}
-//			else
-//			{
-//				DebugPrintf("Get PageBoundingBox OK!\n");
-//			}
-//			DebugPrintf("%%%%PageBoundingBox: %d %d %d %d\n",
-//				bounding_box[0], bounding_box[1], bounding_box[2], bounding_box[3]);
+			parse_bounding_box(line + 18, pageinfo->bounding_box);
 		}
 		else if (!strncmp(line, "%%PageCustomColors:", 19))
 		{
@@ -490,6 +519,7 @@ ssize_t	copy_page(
 			}
 			else if (!strncmp(line, "%%PageBoundingBox:", 18))
 			{
+				parse_bounding_box(line + 18, pageinfo->bounding_box);
 				continue;
 			}
 			else if (!strncmp(line, "%%Include", 9))
@@ -638,6 +668,53 @@ void copy_bytes(
 	}
 }
 
+// %%PageBoundingBox: llx lly urx ury, left as is on "(atend)" or a bad line
+void parse_bounding_box(
+	const char		*s,
+	int				bounding_box[4]
+)
+{
+	int		box[4];
+
+	if (sscanf(s, "%d%d%d%d", box + 0, box + 1, box + 2, box + 3) == 4)
+		memcpy(bounding_box, box, sizeof(box));
+	else
+		DebugPrintf("Bad %%%%PageBoundingBox:%s", s);
+}
+
+// The part of the paper a page is rendered for, FALSE when it is the whole
+// paper because the page has no bounding box or one not smaller than that.
+BOOL page_box(
+	DEVDATA				*pdev,
+	const pstops_page_t	*pageinfo,
+	PAGEBOX				*pbox
+)
+{
+	int		nWidth = (int)pdev->dm.dmPaperWidth;
+	int		nLength = (int)pdev->dm.dmPaperLength;
+	int		left, bottom, right, top;
+
+	memset(pbox, 0, sizeof(PAGEBOX));
+
+	left   = max(pageinfo->bounding_box[0], 0);
+	bottom = max(pageinfo->bounding_box[1], 0);
+	right  = min(pageinfo->bounding_box[2], nWidth);
+	top    = min(pageinfo->bounding_box[3], nLength);
+
+	if (right <= left || top <= bottom)
+		return FALSE;
+	if ((right - left) * (top - bottom) >= nWidth * nLength)
+		return FALSE;
+
+	pbox->left   = left;
+	pbox->bottom = bottom;
+	pbox->right  = right;
+	pbox->top    = top;
+
+	DebugPrintf("Page %s rendered for %d %d %d %d\n", pageinfo->label, left, bottom, right, top);
+	return TRUE;
+}
+
 char * parse_text(
 	const char	*start,
 	char		**end,
@@ -28,6 +28,8 @@
  * Contents:
  *
  *   cupsRasterClose()         - Close a raster stream.
+ *   cupsRasterError()         - Tell a rejected page header from the end of
+ *                               the stream.
  *   cupsRasterOpen()          - Open a raster stream.
  *   cupsRasterReadHeader()    - Read a raster page header and store it in a
  *                               V1 page header structure.
@@ -56,6 +58,7 @@
 #include "raster.h"
 #include "common.h"
 #include "debug.h"
+#include "probe.h"
 //#include "cupsinc/debug.h"
 #include <stdlib.h>
 #include <errno.h>
@@ -68,6 +71,13 @@
 #endif /* WIN32 || __EMX__ */
 
 
+/*
+ * Limits...
+ */
+
+#define CUPS_RASTER_MAX_LINE	0x100000	/* Longest row allocated */
+
+
 /*
  * Private structures...
  */
@@ -90,6 +100,7 @@ struct _cups_raster_s			/**** Raster stream data ****/
 			*bufptr,	/* Current (read) position in buffer */
 			*bufend;	/* End of current (read) buffer */
   int			bufsize;	/* Buffer size */
+  int			error;		/* Non-zero if a header was rejected */
 };
 
 
@@ -195,6 +206,18 @@ cupsRasterOpen(int         fd,		/* I - File descriptor */
 }
 
 
+/*
+ * 'cupsRasterError()' - Tell a rejected page header from the end of the
+ *                       stream after a header read fails.
+ */
+
+int					/* O - 1 if a header was rejected */
+cupsRasterError(cups_raster_t *r)	/* I - Raster stream */
+{
+  return (r ? r->error : 0);
+}
+
+
 /*
  * 'cupsRasterReadHeader()' - Read a raster page header and store it in a
  *                            V1 page header structure.
@@ -283,6 +306,8 @@ cupsRasterReadPixels(cups_raster_t *r,	/* I - Raster stream */
     if (!cups_read(r->fd, p, len))
       return (0);
 
+    TSC_PROBE2(raster__rows, len, len / r->header.cupsBytesPerLine);
+
    /*
     * Swap bytes as needed...
     */
@@ -332,6 +357,8 @@ cupsRasterReadPixels(cups_raster_t *r,	/* I - Raster stream */
       if (r->count > 1)
 	ptr = r->pixels;
 
+      TSC_PROBE2(raster__rows, cupsBytesPerLine, r->count);
+
       temp  = ptr;
       bytes = cupsBytesPerLine;
 
@@ -592,6 +619,23 @@ cups_raster_read_header(
 	 len --, s ++)
       s->v = (((((s->b[3] << 8) | s->b[2]) << 8) | s->b[1]) << 8) | s->b[0];
 
+ /*
+  * Reject a header that does not describe its rows before a row is
+  * allocated for it...
+  */
+
+  if (r->header.cupsBytesPerLine == 0 ||
+      r->header.cupsBytesPerLine > CUPS_RASTER_MAX_LINE ||
+      r->header.cupsBitsPerPixel == 0 || r->header.cupsBitsPerPixel > 240 ||
+      r->header.cupsBitsPerColor == 0 || r->header.cupsBitsPerColor > 16 ||
+      (double)r->header.cupsWidth * (r->header.cupsColorOrder == CUPS_ORDER_CHUNKED ?
+          r->header.cupsBitsPerPixel : r->header.cupsBitsPerColor) >
+          (double)r->header.cupsBytesPerLine * 8)
+  {
+    r->error = 1;
+    return (0);
+  }
+
  /*
   * Update the header and row count...
   */
@@ -330,6 +330,7 @@ extern unsigned		cupsRasterReadHeader2(cups_raster_t *r,
 			                      cups_page_header2_t *h);
 extern unsigned		cupsRasterWriteHeader2(cups_raster_t *r,
 			                       cups_page_header2_t *h);
+extern int		cupsRasterError(cups_raster_t *r);
 
 #  ifdef __cplusplus
 }
@@ -28,14 +28,30 @@
 #include "cupsinc/ppd.h"
 //#include "cupsinc/string.h"
 #include "raster.h"
+#include "netio.h"
+#include "session.h"
+#include "status.h"
+#include "checkpoint.h"
+#include "jobcache.h"
+#include "resample.h"
+#include "barcode.h"
+#include "probe.h"
+#include <math.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
 //#include <stdlib.h>
 //#include <unistd.h>
 //#include <fcntl.h>
 //#include <signal.h>
 
-#define	DRAWMODE_COPY			0
-#define	DRAWMODE_OR				1
-#define	DRAWMODE_XOR			2
+#define	POOL_MAX_PRINTERS		16
+#define	PAGEINDEX_CHUNK			4096	/* Pages per chunk of the page index */
+#define	RASTER_MAX_RESOLUTION	2400	/* dpi */
+#define	RASTER_SIZE_FACTOR		2		/* Raster up to twice the largest label of the model */
+#define	RASTER_TIME_ROWS		1023	/* MaxRasterTime is checked every 1024 rows */
+#define	SPEED_DENSE_INK			50		/* % of dots black, a dense 2D barcode */
+#define	SPEED_DENSE_EDGES		30		/* Edges per 100 dots, modules of about 3 dots */
 
 typedef struct _pageinfo_t
 {
@@ -43,14 +59,40 @@ typedef struct _pageinfo_t
 	unsigned		height;				/* Height of page image in pixels */
 	off_t			offset;				/* Offset to start of page */
 	ssize_t			length;				/* Number of bytes for page */
+	float			paper_width;		/* Label size of page in points */
+	float			paper_length;
+	WORD			speed;				/* dmAdaptiveSpeed, 1/10 inch/sec */
+	WORD			barcodes;			/* dmBarcodes, BARCODE records after the bitmap */
 }	pageinfo_t;
 
+typedef struct _pageindex_t
+{
+	pageinfo_t		**chunks;			/* PAGEINDEX_CHUNK pages each */
+	DWORD			count;				/* Pages in the index */
+	DWORD			alloc;				/* Chunk pointers allocated */
+}	pageindex_t;
+
+typedef struct _jobtime_t
+{
+	double			host;					/* Seconds decoding, composing and encoding */
+	double			link;					/* Seconds blocked writing to the printer */
+	double			wait;					/* Seconds waiting for the printer status */
+	double			head;					/* Seconds printing at the label speed, estimated */
+	double			bytes;					/* Sent to the printer */
+	double			start;					/* Write time and bytes before the job */
+	double			start_bytes;
+	DWORD			labels;
+}	jobtime_t;
+
 typedef struct _doc_t
 {
 	char			tempfile[1024];			/* Temporary filename */
 	FILE			*fp_temp;				/* Temporary file for read, if any */
 
-	cups_array_t	*pages;					/* Pages in document */
+	pageindex_t		pages;					/* Pages in document */
+	unsigned		first_page;				/* Pages before it are printed already */
+	unsigned		across;					/* Logical labels per physical row */
+	jobtime_t		time;					/* Print time report */
 
 }	doc_t;
 
@@ -59,14 +101,46 @@ static DEVDATA* DrvEnable(int argc, char *argv[]);
 static void DrvDisable(DEVDATA *pdev);
 static BOOL bInitCupsOptions(DEVDATA *pdev, char *argv[]);
 static int ParseDocData(DEVDATA *pdev, int fd, doc_t *doc);
+static BOOL CheckRasterHeader(DEVDATA *pdev, cups_page_header_t *header);
 static void FreeDocData(DEVDATA *pdev, doc_t *doc);
+static pageinfo_t* PageAdd(pageindex_t *index);
+static pageinfo_t* PageGet(pageindex_t *index, DWORD dwPage);
+static void PageFree(pageindex_t *index);
+static BOOL RotateLandscape(DEVDATA *pdev, cups_page_header_t *header);
+static WORD PageSpeed(DEVDATA *pdev, const BYTE *pBits, unsigned cbRow, unsigned nHeight);
+static void Rotate90(const BYTE *pSrc, unsigned nWidth, unsigned nHeight, size_t cbSrc, BYTE *pDst);
+static int ComposeAcross(DEVDATA *pdev, doc_t *doc);
+static BOOL ComposeRow(DEVDATA *pdev, doc_t *doc, cups_file_t *temp, const int *pages, BYTE *pRow,
+						unsigned nWidth, unsigned nHeight, unsigned xFirst, unsigned xPitch, WORD *pwBarcodes);
+static int PageBarcodes(DEVDATA *pdev, BYTE *pBits, unsigned cbRow, unsigned nWidth, unsigned nHeight,
+						BARCODE *pCodes);
+static BOOL SessionConnect(DEVDATA *pdev);
+static BOOL SessionDisconnect(DEVDATA *pdev);
+static BOOL SendPage(DEVDATA *pdev, doc_t *doc, pageinfo_t *pageinfo);
+static BOOL SendJobStart(DEVDATA *pdev, DWORD dwCount);
+static BOOL SendLabels(DEVDATA *pdev, doc_t *doc, DWORD dwFirst, DWORD dwCount);
+static DWORD CutInterval(DEVMODE *pdm);
+static DWORD ResumeFirstPage(CHECKPOINT *pckpt);
+static int PoolPrint(DEVDATA *pdev, doc_t *doc);
+static void JobTimeStart(doc_t *doc);
+static void JobTimeLabel(DEVDATA *pdev, doc_t *doc, pageinfo_t *pageinfo, DWORD dwLabel, DWORD dwRun,
+							double dSeconds, double dWait, double dLink, double dBytes);
+static void JobTimeReport(DEVDATA *pdev, doc_t *doc);
+static const char* JobTimeLimit(double dHost, double dLink, double dHead);
+static BOOL PoolPrintShard(DEVDATA *pdev, doc_t *doc, const char *szURI, DWORD dwFirst, DWORD dwCount);
 size_t printer_write(const void* pbuf, size_t cbbuf);
 int printer_printf(const char* strfmt, ...);
 
 int TSPL_SendJobStart(DEVMODE *pdm);
+int TSPL_SendJobAppend(DEVMODE *pdm);
 int TSPL_SendJobEnd(DEVMODE *pdm);
+int TSPL_SetupStateDiscard(DEVMODE *pdm);
+int TSPL_SendCutInterval(DEVMODE *pdm, unsigned nLabels);
 int TSPL_SendPageStart(DEVMODE *pdm);
 int TSPL_SendPageEnd(DEVMODE *pdm);
+int TSPL_SendBitmapFile(DEVMODE *pdm, int nWidth, int nHeight, int fd, off_t offset);
+int TSPL_SendBarcode(DEVMODE *pdm, int x, int y, const char *pszType, int nHeight, int nNarrow, const char *pszData);
+void TSPL_WriteStats(double *pdSeconds, double *pdBytes);
 
 int
 main(int  argc, char *argv[])
@@ -76,8 +150,15 @@ main(int  argc, char *argv[])
 //	cups_page_header_t	header;	/* Page header from file */
 	doc_t				doc;
 //	ppd_file_t			*ppd;	/* PPD file */
-	int					page;	/* Current page */
-	int					copies;	/* Current copies */
+	BOOL				bSession = FALSE;
+	BOOL				bCache;
+	DWORD				dwJobId;
+	DWORD				dwResumeJob = 0;
+	DWORD				dwResume = 0;	/* Labels printed before */
+	DWORD				dwLabels;
+	CHECKPOINT			ckpt;
+	int					ret;
+	double				dStart;
 	DEVDATA				*pdev = NULL;
 
 //	DebugPrintf("#ENTER:rastertobarcodetspl\n");
@@ -103,6 +184,7 @@ main(int  argc, char *argv[])
 		fputs("ERROR: rastertoepson job-id user title copies options [file]\n", stderr);
 		return (1);
 	}
+	dwJobId = atoi(argv[1]);
 
 	/*
 	* Open the page stream...
@@ -128,13 +210,62 @@ main(int  argc, char *argv[])
 	}
 
 	memset(&doc, 0, sizeof(doc));
+
+	// Continue a failed job from its first unconfirmed label, a pool job starts over
+	if ( pdev->dm.dmPrinterPool[0] )
+		dwResumeJob = 0;
+	else if ( pdev->dm.dmResumeJob )
+		dwResumeJob = pdev->dm.dmResumeJob;
+	else if ( pdev->dm.dmCheckpoint == DMCHECKPOINT_ON )
+		dwResumeJob = dwJobId;
+	if ( dwResumeJob && CheckpointLoad(pdev, dwResumeJob, &ckpt) && ckpt.dwDone > 0 )
+		doc.first_page = ResumeFirstPage(&ckpt);
+	else
+		dwResumeJob = 0;
+
+	// A reprint of the same document with the same settings comes from the output cache
+	bCache = ( pdev->dm.dmJobCache == DMJOBCACHE_ON && !dwResumeJob
+				&& !pdev->dm.dmPrinterPool[0] && pdev->dm.dmLabelSession != DMLABELSESSION_ON );
+	if ( bCache && (fd = JobCacheLookup(&pdev->dm, fd)) < 0 )
+	{
+		DrvDisable(pdev);
+		return (1);
+	}
+	if ( bCache && pdev->dm.dmJobCacheHit && !CheckTrialTime() )
+	{
+		ret = JobCacheSend(&pdev->dm, fileno(stdout)) ? 0 : 1;
+		DrvDisable(pdev);
+		if (fd != 0)
+			close(fd);
+		return ret;
+	}
+
 	// Process pages as needed...
-	if ( ParseDocData(pdev, fd, &doc) )
+	doc.across = max(pdev->dm.dmLabelsAcross, 1);
+	dStart = GetSeconds();
+	if ( ParseDocData(pdev, fd, &doc) || ComposeAcross(pdev, &doc) )
 	{
 		Error_Log(LEVEL_ERROR, "Raster Data Error.\n");
+		FreeDocData(pdev, &doc);
 		DrvDisable(pdev);
 		return (1);
 	}
+	doc.time.host = GetSeconds() - dStart;
+	dwLabels = pdev->dm.dmDocPages * pdev->dm.dmCopies;
+
+	if ( dwResumeJob )
+	{
+		if ( ckpt.dwPages != pdev->dm.dmDocPages || ckpt.dwCopies != pdev->dm.dmCopies
+			|| ckpt.wCollate != (pdev->dm.dmCollate ? 1 : 0) || ckpt.dwDone >= dwLabels )
+		{
+			Error_Log(LEVEL_ERROR, "Checkpoint of job %u does not match this job, cannot resume.\n", dwResumeJob);
+			FreeDocData(pdev, &doc);
+			DrvDisable(pdev);
+			return (1);
+		}
+		dwResume = ckpt.dwDone;
+		Error_Log(LEVEL_INFO, "Resume job %u at label %u of %u\n", dwResumeJob, dwResume + 1, dwLabels);
+	}
 
 
 	if ( CheckTrialTime() )
@@ -145,44 +276,74 @@ main(int  argc, char *argv[])
 		return (1);
 	}	
 
-	TSPL_SendJobStart(&pdev->dm);
-
-	for ( copies=0; copies<(pdev->dm.dmCollate ? pdev->dm.dmCopies : 1); copies++ )
+	// Labels are split across the printers of the pool
+	if ( pdev->dm.dmPrinterPool[0] )
 	{
-		DebugPrintf("--copies %d --\n", copies);
-		for(page=0; page<pdev->dm.dmDocPages; page++)
-		{
-			pageinfo_t	*pageinfo = (pageinfo_t*)pdev->lib_cups.cupsArrayIndex(doc.pages, page);
+		int		ret = PoolPrint(pdev, &doc);
 
-			if ( pageinfo )
-			{
-				unsigned char	*PlaneData;
+		FreeDocData(pdev, &doc);
+		DrvDisable(pdev);
+		if (fd != 0)
+			close(fd);
+		return ret;
+	}
 
-				DebugPrintf("PAGE: %d\n", page + 1);
-				DebugPrintf("pageinfo->offset=%d, pageinfo->length=%d\n", pageinfo->offset, pageinfo->length);
+	// The label session service owns the job preamble and printer connection
+	if ( pdev->dm.dmLabelSession == DMLABELSESSION_ON )
+		bSession = SessionConnect(pdev);
 
-				PlaneData = MEMALLOC(pageinfo->length);
-				if ( fseek(doc.fp_temp, pageinfo->offset, SEEK_SET) >= 0)
-				{
-					if ( fread(PlaneData, 1, pageinfo->length, doc.fp_temp) == pageinfo->length )
-					{
-						DebugPrintf("PAGE START\n");
-						TSPL_SendPageStart(&pdev->dm);
+	if ( bCache )
+		JobCacheRecord(&pdev->dm);
 
-						printer_printf("BITMAP %d,%d,%d,%d,%d,", 0, 0, WIDTHBYTES_8(pageinfo->width), pageinfo->height, DRAWMODE_OR);
-						printer_write(PlaneData, pageinfo->length);
-						printer_printf("\r\n");
+	JobTimeStart(&doc);
+	ret = 0;
+	if ( !bSession )
+	{
+		PrinterStatusInit(pdev, -1);
+		ret = SendJobStart(pdev, dwLabels - dwResume) ? 0 : 1;
+	}
+	else if ( TSPL_SendJobAppend(&pdev->dm) < 0 )
+		ret = 1;
 
-						DebugPrintf("PAGE END\n");
-						TSPL_SendPageEnd(&pdev->dm);
-					}
-				}
-				MEMFREE(PlaneData);
-			}
+	if ( pdev->dm.dmCheckpoint == DMCHECKPOINT_ON )
+		CheckpointOpen(pdev, dwJobId, dwResume);
+
+	if ( ret == 0 )
+		ret = SendLabels(pdev, &doc, dwResume, dwLabels - dwResume) ? 0 : 1;
+
+	if ( bSession )
+	{
+		// Without the trailer the service drops what it got of the job
+		if ( ret == 0 && !SessionDisconnect(pdev) )
+			ret = 1;
+	}
+	else
+	{
+		// All output out, then the printer is asked whether it printed it.
+		// The setup of a failed job is not saved for the next one.
+		if ( ret )
+			TSPL_SetupStateDiscard(&pdev->dm);
+		if ( TSPL_SendJobEnd(&pdev->dm) < 0 )
+			ret = 1;
+		if ( ret == 0 && !PrinterStatusDrain(pdev) )
+		{
+			TSPL_SetupStateDiscard(&pdev->dm);
+			ret = 1;
 		}
+		PrinterStatusEnd(pdev);
 	}
+	if ( ret )
+		Error_Log(LEVEL_ERROR, "Job not completed\n");
+	JobTimeReport(pdev, &doc);
+
+	JobCacheCommit(ret == 0);
 
-	TSPL_SendJobEnd(&pdev->dm);
+	// A failed job keeps its checkpoint for the next try
+	if ( ret == 0 )
+		CheckpointUpdate(dwLabels);
+	CheckpointClose(ret == 0);
+	if ( ret == 0 && dwResumeJob && dwResumeJob != dwJobId )
+		CheckpointRemove(pdev, dwResumeJob);
 
 	FreeDocData(pdev, &doc);
 
@@ -193,7 +354,384 @@ main(int  argc, char *argv[])
 
 //	DebugPrintf("#LEAVE:rastertobarcodetspl\n");
 	Error_Log(LEVEL_DEBUG, "### End rastertobarcodetspl ###\n");
-	return (page == 0);
+	return (dwLabels == 0 || ret);
+}
+
+BOOL SendPage(DEVDATA *pdev, doc_t *doc, pageinfo_t *pageinfo)
+{
+	BOOL	bRtn = TRUE;
+
+	DebugPrintf("pageinfo->offset=%d, pageinfo->length=%d\n", pageinfo->offset, pageinfo->length);
+
+	// SIZE follows the page when it is not the size of the one before
+	pdev->dm.dmPaperWidth  = pageinfo->paper_width;
+	pdev->dm.dmPaperLength = pageinfo->paper_length;
+
+	// So does SPEED, slower for the labels with fine content
+	if ( pdev->dm.dmAdaptiveSpeed == DMADAPTIVESPEED_ON && pageinfo->speed )
+	{
+		pdev->dm.dmPrintSpeed = pageinfo->speed;
+		pdev->dm.dmFields |= DM_PRINTSPEED;
+	}
+
+	DebugPrintf("PAGE START\n");
+	if ( TSPL_SendPageStart(&pdev->dm) < 0 )
+		bRtn = FALSE;
+
+	// The page store holds the bitmap ready to send, copy it in the kernel
+	if ( bRtn && TSPL_SendBitmapFile(&pdev->dm, pageinfo->width, pageinfo->height, fileno(doc->fp_temp), pageinfo->offset) < 0 )
+	{
+		Error_Log(LEVEL_ERROR, "IO error: %s\n", strerror(errno));
+		bRtn = FALSE;
+	}
+
+	// The symbols taken out of the bitmap, drawn by the printer
+	if ( bRtn && pageinfo->barcodes )
+	{
+		size_t		cbCodes = sizeof(BARCODE) * pageinfo->barcodes;
+		BARCODE		*codes = MEMALLOC(cbCodes);
+		char		szData[BARCODE_DATA_LENGTH];
+		int			i;
+
+		if ( codes == NULL || pread(fileno(doc->fp_temp), codes, cbCodes,
+					pageinfo->offset + (off_t)WIDTHBYTES_8(pageinfo->width) * pageinfo->height) != cbCodes )
+		{
+			Error_Log(LEVEL_ERROR, "IO error: %s\n", strerror(errno));
+			bRtn = FALSE;
+		}
+		else
+		{
+			for (i=0; bRtn && i<pageinfo->barcodes; i++)
+			{
+				BarcodeData(codes + i, szData);
+				if ( TSPL_SendBarcode(&pdev->dm, codes[i].x, codes[i].y, BarcodeType(codes + i), codes[i].height, codes[i].narrow, szData) < 0 )
+					bRtn = FALSE;
+			}
+		}
+		MEMFREE(codes);
+	}
+
+	DebugPrintf("PAGE END\n");
+	if ( bRtn && TSPL_SendPageEnd(&pdev->dm) < 0 )
+		bRtn = FALSE;
+	return bRtn;
+}
+
+// Job preamble for dwCount labels of the job
+BOOL SendJobStart(DEVDATA *pdev, DWORD dwCount)
+{
+	DWORD		dwCopies = pdev->dm.dmCopies;
+	DWORD		dwDocPages = pdev->dm.dmDocPages;
+	int			iRtn;
+
+	// Cut after job means after the labels sent now
+	if ( pdev->dm.dmOccurrence == DMOCCURRENCE_JOB )
+	{
+		pdev->dm.dmCopies = dwCount;
+		pdev->dm.dmDocPages = 1;
+	}
+	iRtn = TSPL_SendJobStart(&pdev->dm);
+
+	pdev->dm.dmCopies = dwCopies;
+	pdev->dm.dmDocPages = dwDocPages;
+	return iRtn >= 0;
+}
+
+/*
+	The job prints dmDocPages * dmCopies labels. Label n is page n % pages
+	when collated, page n / copies otherwise. Labels dwFirst up to
+	dwFirst + dwCount are sent, identical labels in a row as one PRINT 1,n.
+*/
+BOOL SendLabels(DEVDATA *pdev, doc_t *doc, DWORD dwFirst, DWORD dwCount)
+{
+	DWORD		dwLabel;
+	DWORD		dwRun;
+	DWORD		dwCopies = pdev->dm.dmCopies;
+	WORD		wCollate = pdev->dm.dmCollate;
+	DWORD		dwPages = pdev->dm.dmDocPages;
+	pageinfo_t	*pageinfo;
+	BOOL		bRtn = TRUE;
+	double		dStart;
+	double		dWait;
+	double		dLink;
+	double		dLinkEnd;
+	double		dBytes;
+	double		dBytesEnd;
+	DWORD		dwCut = CutInterval(&pdev->dm);
+	DWORD		dwRebase = 0;	/* Label the full cut interval starts at again */
+
+	if ( doc->fp_temp == NULL )
+		return FALSE;
+
+	// A resumed job starts inside a cut interval, the first cut is after
+	// the labels left of it
+	if ( dwCut > 1 && dwFirst % dwCut )
+	{
+		dwRebase = dwFirst + dwCut - dwFirst % dwCut;
+		if ( TSPL_SendCutInterval(&pdev->dm, dwRebase - dwFirst) < 0 )
+			return FALSE;
+	}
+
+	pdev->dm.dmCollate = 0;
+	for (dwLabel = dwFirst; dwLabel < dwFirst + dwCount; dwLabel += dwRun)
+	{
+		if ( wCollate )
+		{
+			pageinfo = PageGet(&doc->pages, dwLabel % dwPages);
+			dwRun = 1;
+		}
+		else
+		{
+			pageinfo = PageGet(&doc->pages, dwLabel / dwCopies);
+			dwRun = min(dwCopies - dwLabel % dwCopies, dwFirst + dwCount - dwLabel);
+		}
+		if ( dwLabel < dwRebase )
+			dwRun = min(dwRun, dwRebase - dwLabel);
+		if ( pageinfo == NULL || pageinfo->length == 0 )
+		{
+			bRtn = FALSE;
+			break;
+		}
+
+		DebugPrintf("LABEL: %u x %u\n", dwLabel + 1, dwRun);
+		pdev->dm.dmCopies = dwRun;
+		dStart = GetSeconds();
+		TSPL_WriteStats(&dLink, &dBytes);
+		PrinterStatusWait(pdev, pageinfo->length, dwRun);
+		dWait = GetSeconds() - dStart;
+		if ( !SendPage(pdev, doc, pageinfo) )
+		{
+			bRtn = FALSE;
+			break;
+		}
+		TSPL_WriteStats(&dLinkEnd, &dBytesEnd);
+		JobTimeLabel(pdev, doc, pageinfo, dwLabel, dwRun, GetSeconds() - dStart, dWait, dLinkEnd - dLink, dBytesEnd - dBytes);
+
+		// Labels sent less those the printer is not expected to have printed,
+		// without status polling the count written. The job end confirms all.
+		CheckpointUpdate(dwLabel + dwRun - min(PrinterStatusPending(), dwLabel + dwRun));
+
+		if ( dwLabel + dwRun == dwRebase && TSPL_SendCutInterval(&pdev->dm, dwCut) < 0 )
+		{
+			bRtn = FALSE;
+			break;
+		}
+	}
+
+	pdev->dm.dmCopies = dwCopies;
+	pdev->dm.dmCollate = wCollate;
+	return bRtn;
+}
+
+// Labels from one cut to the next as the job preamble sets the cutter,
+// 0 when it does not count labels of the job
+DWORD CutInterval(DEVMODE *pdm)
+{
+	if ( pdm->dmPostAction != DMPOSTACTION_CUT && pdm->dmPostAction != DMPOSTACTION_PARTIAL )
+		return 0;
+
+	switch ( pdm->dmOccurrence )
+	{
+	case DMOCCURRENCE_COPIES:
+		return pdm->dmCopies;
+	case DMOCCURRENCE_SPECIFIED:
+		return pdm->dmCutInterval;
+	}
+	return 0;
+}
+
+// First page a resumed job needs, pages before it are not stored again
+DWORD ResumeFirstPage(CHECKPOINT *pckpt)
+{
+	if ( pckpt->dwPages == 0 || pckpt->dwCopies == 0 )
+		return 0;
+
+	// Collated, every page is needed again until the last copy
+	if ( pckpt->wCollate )
+		return pckpt->dwDone / pckpt->dwPages + 1 < pckpt->dwCopies ? 0 : pckpt->dwDone % pckpt->dwPages;
+
+	return pckpt->dwDone / pckpt->dwCopies;
+}
+
+/*
+	Every printer of the pool gets a contiguous range of the label
+	sequence of SendLabels() as a job of its own.
+*/
+int PoolPrint(DEVDATA *pdev, doc_t *doc)
+{
+	char			szPool[DM_PRINTERPOOL_LENGTH];
+	char			*szURIs[POOL_MAX_PRINTERS];
+	pid_t			pids[POOL_MAX_PRINTERS];
+	char			*p;
+	int				nPrinters = 0;
+	int				nFailed = 0;
+	int				i;
+	int				status;
+	DWORD			dwLabels = pdev->dm.dmDocPages * pdev->dm.dmCopies;
+	double			dBytes = 0;
+	double			dSeconds;
+	struct timeval	tvStart;
+	struct timeval	tvEnd;
+
+	strcpy(szPool, pdev->dm.dmPrinterPool);
+	for (p = strtok(szPool, ", "); p && nPrinters < POOL_MAX_PRINTERS; p = strtok(NULL, ", "))
+		szURIs[nPrinters++] = p;
+
+	if ( nPrinters == 0 || dwLabels == 0 )
+		return 1;
+	if ( nPrinters > dwLabels )
+		nPrinters = dwLabels;
+
+	for (i=0; i<pdev->dm.dmDocPages; i++)
+	{
+		pageinfo_t	*pageinfo = PageGet(&doc->pages, i);
+
+		if ( pageinfo )
+			dBytes += (double)pageinfo->length * pdev->dm.dmCopies;
+	}
+
+	Error_Log(LEVEL_INFO, "Printer pool: %u labels on %d printers\n", dwLabels, nPrinters);
+
+	// The checkpoint holds the labels done in job order, not the ranges of
+	// the printers, so a pool job is not resumed
+	if ( pdev->dm.dmCheckpoint == DMCHECKPOINT_ON )
+		Error_Log(LEVEL_WARNING, "No checkpoint for a printer pool, a failed job prints again from the first label\n");
+
+	gettimeofday(&tvStart, NULL);
+	for (i=0; i<nPrinters; i++)
+	{
+		DWORD	dwFirst = (DWORD)((double)dwLabels * i / nPrinters);
+		DWORD	dwLast  = (DWORD)((double)dwLabels * (i + 1) / nPrinters);
+
+		if ( (pids[i] = fork()) == 0 )
+			_exit(PoolPrintShard(pdev, doc, szURIs[i], dwFirst, dwLast - dwFirst) ? 0 : 1);
+		if ( pids[i] < 0 )
+		{
+			Error_Log(LEVEL_ERROR, "Unable to start pool printer %s - %s\n", szURIs[i], strerror(errno));
+			nFailed ++;
+		}
+	}
+
+	for (i=0; i<nPrinters; i++)
+	{
+		if ( pids[i] <= 0 )
+			continue;
+		while ( waitpid(pids[i], &status, 0) < 0 && errno == EINTR )
+			;
+		if ( !WIFEXITED(status) || WEXITSTATUS(status) )
+		{
+			Error_Log(LEVEL_ERROR, "Pool printer %s failed, labels %u-%u not confirmed\n", szURIs[i],
+						(DWORD)((double)dwLabels * i / nPrinters) + 1, (DWORD)((double)dwLabels * (i + 1) / nPrinters));
+			nFailed ++;
+		}
+	}
+	gettimeofday(&tvEnd, NULL);
+
+	dSeconds = (tvEnd.tv_sec - tvStart.tv_sec) + (tvEnd.tv_usec - tvStart.tv_usec) / 1000000.0;
+	if ( dSeconds <= 0 )
+		dSeconds = 0.000001;
+	Error_Log(LEVEL_INFO, "Printer pool: %u labels, %.0f KB in %.2f s, %.1f labels/s, %.0f KB/s\n",
+				dwLabels, dBytes / 1024, dSeconds, dwLabels / dSeconds, dBytes / 1024 / dSeconds);
+
+	return nFailed ? 1 : 0;
+}
+
+/*
+	Print time report. A label takes its length and gap at its speed on
+	the printer, its bytes take the time blocked writing them on the
+	link, the rest of the time sending it is the host's. The job runs at
+	the pace of the slowest of the three.
+*/
+void JobTimeStart(doc_t *doc)
+{
+	TSPL_WriteStats(&doc->time.start, &doc->time.start_bytes);
+}
+
+void JobTimeLabel(DEVDATA *pdev, doc_t *doc, pageinfo_t *pageinfo, DWORD dwLabel, DWORD dwRun,
+					double dSeconds, double dWait, double dLink, double dBytes)
+{
+	WORD		wSpeed = pdev->dm.dmPrintSpeed;
+	float		fFeed = pageinfo->paper_length;
+	double		dHead = 0;
+	double		dHost = max(dSeconds - dWait - dLink, 0);
+
+	if ( pdev->dm.dmMediaType != DMMEDIATYPE_CONTINUE )
+		fFeed += pdev->dm.dmGapHeight;
+	if ( (pdev->dm.dmFields & DM_PRINTSPEED) && wSpeed )
+		dHead = POINT2INCH(fFeed) * 10 / wSpeed * dwRun;
+
+	doc->time.host += dHost;
+	doc->time.wait += dWait;
+	doc->time.head += dHead;
+	doc->time.labels += dwRun;
+
+	Error_Log(LEVEL_DEBUG, "Label %u x %u: %.0f bytes, host %.1f ms, link %.1f ms, head %.1f ms, limited by the %s\n",
+				dwLabel + 1, dwRun, dBytes, dHost * 1000, (dLink + dWait) * 1000, dHead * 1000,
+				JobTimeLimit(dHost, dLink + dWait, dHead));
+}
+
+void JobTimeReport(DEVDATA *pdev, doc_t *doc)
+{
+	jobtime_t	*jt = &doc->time;
+	double		dWrite;
+
+	TSPL_WriteStats(&dWrite, &jt->bytes);
+	jt->link = dWrite - jt->start;
+	jt->bytes -= jt->start_bytes;
+
+	Error_Log(LEVEL_INFO, "Print time: %u labels, %.0f KB; host %.2f s, link %.2f s at %.0f KB/s, head %.2f s%s; limited by the %s\n",
+				jt->labels, jt->bytes / 1024, jt->host, jt->link + jt->wait,
+				jt->link > 0 ? jt->bytes / 1024 / jt->link : 0, jt->head,
+				jt->head > 0 ? "" : " (speed unknown)", JobTimeLimit(jt->host, jt->link + jt->wait, jt->head));
+}
+
+// Time blocked on the printer is the head's as long as the head needs that long
+const char* JobTimeLimit(double dHost, double dLink, double dHead)
+{
+	if ( dHead > 0 && dHead >= dHost && dHead * 1.1 >= dLink )
+		return "print head";
+	if ( dHost >= dLink )
+		return "host";
+	return "link";
+}
+
+// Runs in a child process of its own, stdout is the printer connection.
+BOOL PoolPrintShard(DEVDATA *pdev, doc_t *doc, const char *szURI, DWORD dwFirst, DWORD dwCount)
+{
+	int			fd;
+
+	if ( (fd = NetOpenDeviceURI(szURI)) < 0 )
+		return FALSE;
+	if ( dup2(fd, fileno(stdout)) < 0 )
+		return FALSE;
+	close(fd);
+	NetTuneStream(fileno(stdout));
+
+	// The saved setup is of the queue, not of this printer
+	pdev->dm.dmSetupCache = DMSETUPCACHE_OFF;
+
+	// Status pacing of this printer, it answers on its own connection
+	PrinterStatusInit(pdev, fileno(stdout));
+
+	JobTimeStart(doc);
+	if ( !SendJobStart(pdev, dwCount) || !SendLabels(pdev, doc, dwFirst, dwCount)
+		|| TSPL_SendJobEnd(&pdev->dm) < 0 )
+	{
+		Error_Log(LEVEL_ERROR, "Pool printer %s: IO error: %s\n", szURI, strerror(errno));
+		PrinterStatusEnd(pdev);
+		return FALSE;
+	}
+	if ( !PrinterStatusDrain(pdev) )
+	{
+		Error_Log(LEVEL_ERROR, "Pool printer %s: labels not confirmed\n", szURI);
+		PrinterStatusEnd(pdev);
+		return FALSE;
+	}
+	PrinterStatusEnd(pdev);
+	JobTimeReport(pdev, doc);
+
+	Error_Log(LEVEL_INFO, "Pool printer %s: labels %u-%u\n", szURI, dwFirst + 1, dwFirst + dwCount);
+	return TRUE;
 }
 
 int ParseDocData(DEVDATA *pdev, int fd, doc_t *doc)
@@ -204,6 +742,8 @@ int ParseDocData(DEVDATA *pdev, int fd, doc_t *doc)
 	cups_page_header_t	header;			/* Page header from file */
 	unsigned			NumCopies = 0;	/* Number of copies to produce */
 	cups_bool_t			Collate = 0;
+	time_t				tStart = time(NULL);
+	double				dLimit = (double)(pdev->dm.dmRasterMemory ? pdev->dm.dmRasterMemory : RASTERMEMORY_DEF_VALUE) * 1024 * 1024;
 
     if ((temp = pdev->lib_cups.cupsTempFile2(doc->tempfile, sizeof(doc->tempfile))) == NULL)
     {
@@ -211,7 +751,9 @@ int ParseDocData(DEVDATA *pdev, int fd, doc_t *doc)
 		return (1);
 	}
 
-	doc->pages = pdev->lib_cups.cupsArrayNew(NULL, NULL);
+	// Read ahead of the decoder, a spooled raster file only
+	if ( pdev->dm.dmAsyncIO == DMASYNCIO_ON )
+		posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
 
 	ras = cupsRasterOpen(fd, CUPS_RASTER_READ);
 	DebugPrintf("ras->sync: %x\n", *(unsigned*)ras);
@@ -223,9 +765,14 @@ int ParseDocData(DEVDATA *pdev, int fd, doc_t *doc)
 		unsigned			WidthBytes;
 		int					nOutWidth;
 		int					nOutHeight;
+		float				fPaperWidth;
+		float				fPaperLength;
 		pageinfo_t			*pageinfo;
+		RESAMPLE			*pResample = NULL;
+		double				cbPlane;
+		BOOL				bRotate;
 
-		DebugPrintf("PAGE: %d\n", pdev->lib_cups.cupsArrayCount(doc->pages) + 1);
+		DebugPrintf("PAGE: %u\n", doc->pages.count + 1);
 		DebugPrintf("NumCopies=%d\n", header.NumCopies);
 		DebugPrintf("PageSize(%dx%d) HWResolution(%dx%d)\n", header.PageSize[0], header.PageSize[1], header.HWResolution[0], header.HWResolution[1]);
 		DebugPrintf("Margins(%dx%d)\n", header.Margins[0], header.Margins[1]);
@@ -234,9 +781,22 @@ int ParseDocData(DEVDATA *pdev, int fd, doc_t *doc)
 		DebugPrintf("cupsBitsPerPixel=%d, cupsBytesPerLine=%d\n", header.cupsBitsPerPixel, header.cupsBytesPerLine);
 		DebugPrintf("cupsRowCount=%d, cupsRowFeed=%d, cupsRowStep=%d\n", header.cupsRowCount, header.cupsRowFeed, header.cupsRowStep);
 
+		if ( !CheckRasterHeader(pdev, &header) )
+		{
+			ret = 1;
+			break;
+		}
+		TSC_PROBE5(raster__page__start, doc->pages.count + 1, header.cupsWidth, header.cupsHeight,
+					header.HWResolution[0], header.HWResolution[1]);
+
 		nOutWidth  = header.cupsWidth;
 		nOutHeight = header.cupsHeight;
 
+		// A landscape page is printed across the label
+		bRotate = RotateLandscape(pdev, &header);
+		fPaperWidth  = header.PageSize[bRotate ? 1 : 0];
+		fPaperLength = header.PageSize[bRotate ? 0 : 1];
+
 		// Check Page Size
 		if ( header.PageSize[0] > pdev->ppd->custom_max[0] || header.PageSize[1] > pdev->ppd->custom_max[1] )
 		{
@@ -262,9 +822,8 @@ int ParseDocData(DEVDATA *pdev, int fd, doc_t *doc)
 							{
 								DebugPrintf("PageSize: '%s' -> %.3fx%.3f (point)\n", pagesize->name, pagesize->width, pagesize->length);
 								
-								pdev->dm.dmPaperWidth  = pagesize->width;
-								pdev->dm.dmPaperLength = pagesize->length;
-								pdev->dm.dmFields |= DM_PAPERLENGTH | DM_PAPERWIDTH;
+								fPaperWidth  = pagesize->width;
+								fPaperLength = pagesize->length;
 
 								nOutWidth  = (int)(pagesize->width  * header.HWResolution[0] / 72 + 0.5);
 								nOutHeight = (int)(pagesize->length * header.HWResolution[1] / 72 + 0.5);
@@ -278,10 +837,20 @@ int ParseDocData(DEVDATA *pdev, int fd, doc_t *doc)
 			}
 		}
 
+		// Nothing past the paper of the model is printed, so it is not sent
+		if ( pdev->dm.dmMaxPaperWidth > 0 )
+		{
+			if ( bRotate )
+				nOutHeight = min(nOutHeight, (int)(pdev->dm.dmMaxPaperWidth * header.HWResolution[1] / 72 + 0.5));
+			else
+				nOutWidth = min(nOutWidth, (int)(pdev->dm.dmMaxPaperWidth * header.HWResolution[0] / 72 + 0.5));
+		}
+
+		// The job is set up for the first page, every page keeps its own size
 		if ( ! (pdev->dm.dmFields & (DM_PAPERLENGTH | DM_PAPERWIDTH)) )
 		{
-			pdev->dm.dmPaperWidth  = header.PageSize[0];
-			pdev->dm.dmPaperLength = header.PageSize[1];
+			pdev->dm.dmPaperWidth  = fPaperWidth;
+			pdev->dm.dmPaperLength = fPaperLength;
 			pdev->dm.dmFields |= DM_PAPERLENGTH | DM_PAPERWIDTH;
 		}
 		if ( !NumCopies )
@@ -292,17 +861,46 @@ int ParseDocData(DEVDATA *pdev, int fd, doc_t *doc)
 
 		WidthBytes = min(WIDTHBYTES_8(nOutWidth), header.cupsBytesPerLine);
 		DebugPrintf("WidthBytes=%d\n", WidthBytes);
-		pageinfo = MEMALLOC(sizeof(pageinfo_t));
+		pageinfo = PageAdd(&doc->pages);
 		if ( pageinfo )
 		{
 			pageinfo->width  = nOutWidth;
 			pageinfo->height = nOutHeight;
 			pageinfo->offset = pdev->lib_cups.cupsFileTell(temp);
+			pageinfo->paper_width  = fPaperWidth;
+			pageinfo->paper_length = fPaperLength;
+
+			// A raster of another resolution is converted to the printer's as it is read
+			if ( header.HWResolution[0] != pdev->dm.dmPrintQuality || header.HWResolution[1] != pdev->dm.dmYResolution )
+			{
+				pResample = ResampleCreate(min(nOutWidth, WidthBytes * 8), nOutHeight,
+								header.HWResolution[0], header.HWResolution[1], pdev->dm.dmPrintQuality, pdev->dm.dmYResolution);
+				if ( pResample == NULL )
+					Error_Log(LEVEL_WARNING, "Raster is %ux%u dpi, printed as is at %ux%u dpi\n",
+								header.HWResolution[0], header.HWResolution[1], pdev->dm.dmPrintQuality, pdev->dm.dmYResolution);
+			}
 
-			RowData = MEMALLOC(header.cupsBytesPerLine);
-			PlaneData = MEMALLOC(WidthBytes * nOutHeight);
+			if ( pResample )
+				cbPlane = (double)WIDTHBYTES_8(ResampleWidth(pResample)) * ResampleHeight(pResample);
+			else
+				cbPlane = (double)WidthBytes * nOutHeight;
+
+			// The page and, when it is turned, its copy
+			if ( header.cupsBytesPerLine + cbPlane * (bRotate ? 2 : 1) > dLimit )
+			{
+				Error_Log(LEVEL_ERROR, "Page %u needs %.0f MB, more than MaxRasterMemory %u MB\n",
+							doc->pages.count, cbPlane * (bRotate ? 2 : 1) / 1024 / 1024,
+							(unsigned)(dLimit / 1024 / 1024));
+				RowData = PlaneData = NULL;
+				ret = 1;
+			}
+			else
+			{
+				RowData = MEMALLOC(header.cupsBytesPerLine);
+				PlaneData = MEMALLOC((size_t)cbPlane);
+			}
 
-			if ( RowData && PlaneData )
+			if ( ret == 0 && RowData && PlaneData )
 			{
 				for (y = 0; y < header.cupsHeight; y ++)
 				{
@@ -313,32 +911,94 @@ int ParseDocData(DEVDATA *pdev, int fd, doc_t *doc)
 						ret = 1;
 						break;
 					}
+					if ( pdev->dm.dmRasterTime && (y & RASTER_TIME_ROWS) == 0
+						&& time(NULL) - tStart > pdev->dm.dmRasterTime )
+					{
+						Error_Log(LEVEL_ERROR, "Raster not read in MaxRasterTime %u seconds, page %u row %d\n",
+									pdev->dm.dmRasterTime, doc->pages.count, y);
+						ret = 1;
+						break;
+					}
 //					memmove(PlaneData + WidthBytes * (header.cupsHeight-y-1), RowData, WidthBytes);
-					if (y < nOutHeight )
+					if ( y < nOutHeight && pResample )
+						ResampleRow(pResample, RowData, PlaneData);
+					else if (y < nOutHeight )
 						memmove(PlaneData + WidthBytes * y, RowData, WidthBytes);
 				}
-				
-				//
 
-				for(y=0; y<WidthBytes * nOutHeight; y++)
-					PlaneData[y] = ~PlaneData[y];
+				if ( pResample )
+				{
+					ResampleEnd(pResample, PlaneData);
+					nOutWidth  = ResampleWidth(pResample);
+					nOutHeight = ResampleHeight(pResample);
+					WidthBytes = WIDTHBYTES_8(nOutWidth);
+					pageinfo->width  = nOutWidth;
+					pageinfo->height = nOutHeight;
+					DebugPrintf("Resample %ux%u dpi to %ux%u dots\n", header.HWResolution[0], header.HWResolution[1], nOutWidth, nOutHeight);
+				}
 
-				pdev->lib_cups.cupsFileWrite(temp, PlaneData, WidthBytes * nOutHeight);
-				pageinfo->length = pdev->lib_cups.cupsFileTell(temp) - pageinfo->offset;
-				if ( pageinfo->length != WidthBytes * nOutHeight )
+				// Landscape is turned here, 180 degrees more is left to DIRECTION
+				if ( ret == 0 && bRotate )
 				{
-					Error_Log(LEVEL_ERROR, "IO error: %s\n", strerror(errno));
-					ret = 1;
+					unsigned	nWidth = min(nOutWidth, WidthBytes * 8);
+					BYTE		*pRotated = MEMALLOC(WIDTHBYTES_8(nOutHeight) * nWidth);
+
+					if ( pRotated )
+					{
+						Rotate90(PlaneData, nWidth, nOutHeight, WidthBytes, pRotated);
+						MEMFREE(PlaneData);
+						PlaneData = pRotated;
+						pageinfo->width  = nOutHeight;
+						pageinfo->height = nWidth;
+						WidthBytes = WIDTHBYTES_8(nOutHeight);
+						nOutHeight = nWidth;
+					}
+					else
+					{
+						DebugPrintf("No memory: %s\n", strerror(errno));
+						ret = 1;
+					}
+				}
+
+				// A resumed job does not store the pages printed already,
+				// rows of labels across are skipped when they are composed
+				if ( doc->across <= 1 && doc->pages.count <= doc->first_page )
+					pageinfo->length = 0;
+				else
+				{
+					BARCODE		codes[BARCODE_MAX_PAGE];
+
+					if ( pdev->dm.dmAdaptiveSpeed == DMADAPTIVESPEED_ON )
+						pageinfo->speed = PageSpeed(pdev, PlaneData, WidthBytes, nOutHeight);
+					pageinfo->barcodes = PageBarcodes(pdev, PlaneData, WidthBytes, pageinfo->width, nOutHeight, codes);
+
+					for(y=0; y<WidthBytes * nOutHeight; y++)
+						PlaneData[y] = ~PlaneData[y];
+
+					pdev->lib_cups.cupsFileWrite(temp, PlaneData, WidthBytes * nOutHeight);
+					if ( pageinfo->barcodes )
+						pdev->lib_cups.cupsFileWrite(temp, (char*)codes, sizeof(BARCODE) * pageinfo->barcodes);
+					pageinfo->length = pdev->lib_cups.cupsFileTell(temp) - pageinfo->offset;
+					if ( pageinfo->length != WidthBytes * nOutHeight + sizeof(BARCODE) * pageinfo->barcodes )
+					{
+						Error_Log(LEVEL_ERROR, "IO error: %s\n", strerror(errno));
+						ret = 1;
+					}
 				}
 				MEMFREE(RowData);
 				MEMFREE(PlaneData);
+				TSC_PROBE5(raster__page__end, doc->pages.count, pageinfo->width, pageinfo->height,
+							pageinfo->length, ret);
 			}
 			else
 			{
-				DebugPrintf("No memory: %s\n", strerror(errno));
+				if ( ret == 0 )
+					Error_Log(LEVEL_ERROR, "No memory: %s\n", strerror(errno));
+				MEMFREE(RowData);
+				MEMFREE(PlaneData);
 				ret = 1;
 			}
-			pdev->lib_cups.cupsArrayAdd(doc->pages, pageinfo);
+			ResampleDestroy(pResample);
 		}
 		else
 		{
@@ -348,6 +1008,13 @@ int ParseDocData(DEVDATA *pdev, int fd, doc_t *doc)
 		}
 	}
 
+	// A rejected page header is not the end of the document
+	if ( ret == 0 && cupsRasterError(ras) )
+	{
+		Error_Log(LEVEL_ERROR, "Invalid raster header, page %u\n", doc->pages.count + 1);
+		ret = 1;
+	}
+
 	// Close the raster stream...
 	cupsRasterClose(ras);
 
@@ -356,7 +1023,7 @@ int ParseDocData(DEVDATA *pdev, int fd, doc_t *doc)
 
 	if ( NumCopies )
 		pdev->dm.dmCopies = NumCopies;
-	pdev->dm.dmDocPages = pdev->lib_cups.cupsArrayCount(doc->pages);
+	pdev->dm.dmDocPages = doc->pages.count;
 	pdev->dm.dmCollate = pdev->dm.dmDocPages > 1 ? Collate : 0;
 
 	DebugPrintf("pdev->dm.dmDocPages=%d\n", pdev->dm.dmDocPages);
@@ -366,12 +1033,595 @@ int ParseDocData(DEVDATA *pdev, int fd, doc_t *doc)
 	return ret;
 }
 
+/*
+	A landscape page is turned here only when its raster is still landscape
+	to the label: the raster width is nearer the label length than the label
+	width. On the usual CUPS path pdftopdf turned the page before it was
+	rasterized, and that raster has the label width already.
+*/
+BOOL RotateLandscape(DEVDATA *pdev, cups_page_header_t *header)
+{
+	ppd_size_t	*pagesize = NULL;
+	double		dMedia;
+
+	if ( !(pdev->dm.dmFields & DM_ORIENTATION)
+		|| (pdev->dm.dmOrientation != DMORIENT_LANDSCAPE && pdev->dm.dmOrientation != DMORIENT_LANDSCAPE_180) )
+		return FALSE;
+
+	// Label size of the queue, else of the pages before
+	if ( pdev->ppd && pdev->lib_cups.ppdPageSize )
+		pagesize = pdev->lib_cups.ppdPageSize(pdev->ppd, NULL);
+	if ( pagesize && pagesize->width > 0 )
+		dMedia = pagesize->width;
+	else if ( pdev->dm.dmFields & DM_PAPERWIDTH )
+		dMedia = pdev->dm.dmPaperWidth;
+	else
+		return header->PageSize[0] > header->PageSize[1];
+
+	return fabs(header->PageSize[1] - dMedia) < fabs(header->PageSize[0] - dMedia);
+}
+
+/*
+	Turn a 1bpp bitmap 90 degrees counter-clockwise, pixel (x, y) to
+	(y, nWidth - 1 - x). Every 8 rows of pSrc are one band, that is one
+	byte column of pDst, turned 8x8 dots at a time in a 64-bit word.
+	pDst has nWidth rows of WIDTHBYTES_8(nHeight) bytes.
+*/
+void Rotate90(const BYTE *pSrc, unsigned nWidth, unsigned nHeight, size_t cbSrc, BYTE *pDst)
+{
+	size_t		cbDst = WIDTHBYTES_8(nHeight);
+	unsigned	y, x, i;
+
+	for (y = 0; y < nHeight; y += 8)
+	{
+		const BYTE	*pBand = pSrc + cbSrc * y;
+		unsigned	nRows = min(8, nHeight - y);
+		BYTE		*pColumn = pDst + y / 8;
+
+		for (x = 0; x < nWidth; x += 8)
+		{
+			unsigned long long	w = 0;
+			unsigned long long	t;
+
+			// Row 0 in the high byte, rows past the band are white
+			for (i=0; i<nRows; i++)
+				w |= (unsigned long long)pBand[cbSrc * i + x / 8] << (56 - 8 * i);
+			if ( w == 0 )
+			{
+				for (i=0; i<8 && x + i < nWidth; i++)
+					pColumn[cbDst * (nWidth - 1 - x - i)] = 0;
+				continue;
+			}
+
+			// Transpose, byte i is column x + i now, its high bit row y
+			t = (w ^ (w >> 7)) & 0x00AA00AA00AA00AAULL;
+			w = w ^ t ^ (t << 7);
+			t = (w ^ (w >> 14)) & 0x0000CCCC0000CCCCULL;
+			w = w ^ t ^ (t << 14);
+			t = (w ^ (w >> 28)) & 0x00000000F0F0F0F0ULL;
+			w = w ^ t ^ (t << 28);
+
+			for (i=0; i<8 && x + i < nWidth; i++)
+				pColumn[cbDst * (nWidth - 1 - x - i)] = (BYTE)(w >> (56 - 8 * i));
+		}
+	}
+}
+
+/*
+	N-across: the label sequence of SendLabels() is printed N labels per
+	row of a wide liner. Every N consecutive labels are composed into one
+	row bitmap, the columns a pitch of label width + column gap apart,
+	right of the liner margin. The rows take the place of the pages, so
+	copies, cuts, checkpoints and pools count rows from here on.
+
+	Uncollated copies of a page, N at a time, become rows of that page.
+	Collated pages, N at a time, become a collated set of rows. Any other
+	sequence is stored row by row, the last row may be short.
+*/
+int ComposeAcross(DEVDATA *pdev, doc_t *doc)
+{
+	DWORD			dwPages = pdev->dm.dmDocPages;
+	DWORD			dwCopies = pdev->dm.dmCopies;
+	DWORD			dwLabels = dwPages * dwCopies;
+	DWORD			dwRows;
+	DWORD			dwRow;
+	DWORD			N = doc->across;
+	unsigned		nLabelWidth = 0;
+	unsigned		nHeight = 0;
+	float			fLength = 0;
+	float			fMaxWidth = 0;
+	unsigned		xFirst;
+	unsigned		xPitch;
+	unsigned		nWidth;
+	int				layout;					// 0 copies, 1 collated, 2 row by row
+	int				pages[LABELSACROSS_MAX_VALUE];
+	int				last[LABELSACROSS_MAX_VALUE];
+	pageinfo_t		*pageinfo;
+	pageinfo_t		*previous = NULL;
+	pageindex_t		rows;
+	cups_file_t		*temp;
+	char			tempfile[sizeof(doc->tempfile)];
+	BYTE			*pRow;
+	int				ret = 0;
+	DWORD			i;
+
+	if ( N <= 1 || dwLabels == 0 || doc->fp_temp == NULL )
+		return 0;
+
+	for (i=0; i<dwPages; i++)
+	{
+		if ( (pageinfo = PageGet(&doc->pages, i)) == NULL )
+			return 1;
+		nLabelWidth = max(nLabelWidth, pageinfo->width);
+		nHeight = max(nHeight, pageinfo->height);
+		fLength = max(fLength, pageinfo->paper_length);
+	}
+
+	xFirst = (unsigned)(POINT2DOT(pdev->dm.dmLinerLeft, pdev->dm.dmPrintQuality) + 0.5);
+	xPitch = nLabelWidth + (unsigned)(POINT2DOT(pdev->dm.dmColumnGap, pdev->dm.dmPrintQuality) + 0.5);
+	nWidth = xFirst + xPitch * (N - 1) + nLabelWidth
+			+ (unsigned)(POINT2DOT(pdev->dm.dmLinerRight, pdev->dm.dmPrintQuality) + 0.5);
+
+	// The row must fit the paper of the model, else the labels go one by one
+	if ( pdev->dm.dmMaxPaperWidth > 0 )
+		fMaxWidth = pdev->dm.dmMaxPaperWidth;
+	else if ( pdev->ppd && pdev->ppd->custom_max[0] > 0 )
+		fMaxWidth = pdev->ppd->custom_max[0];
+	if ( fMaxWidth > 0 && nWidth > (unsigned)(POINT2DOT(fMaxWidth, pdev->dm.dmPrintQuality) + 0.5) )
+	{
+		Error_Log(LEVEL_WARNING, "%u labels across need %.1f mm, wider than the paper of %.1f mm, printed 1 across\n",
+					N, POINT2MM((float)nWidth * 72 / pdev->dm.dmPrintQuality), POINT2MM(fMaxWidth));
+		doc->across = 1;
+		return 0;
+	}
+
+	if ( !pdev->dm.dmCollate && dwCopies % N == 0 )
+	{
+		layout = 0;
+		dwRows = dwPages;
+	}
+	else if ( pdev->dm.dmCollate && dwPages % N == 0 )
+	{
+		layout = 1;
+		dwRows = dwPages / N;
+	}
+	else
+	{
+		layout = 2;
+		dwRows = (dwLabels + N - 1) / N;
+	}
+
+	if ( (temp = pdev->lib_cups.cupsTempFile2(tempfile, sizeof(tempfile))) == NULL )
+	{
+		Error_Log(LEVEL_ERROR, "Unable to create temporary file: %s\n", strerror(errno));
+		return 1;
+	}
+	memset(&rows, 0, sizeof(rows));
+	pRow = MEMALLOC(WIDTHBYTES_8(nWidth) * nHeight);
+	if ( pRow == NULL )
+	{
+		Error_Log(LEVEL_ERROR, "No memory: %s\n", strerror(errno));
+		ret = 1;
+	}
+
+	for (dwRow = 0; ret == 0 && dwRow < dwRows; dwRow++)
+	{
+		for (i=0; i<N; i++)
+		{
+			DWORD	dwLabel = dwRow * N + i;
+
+			if ( layout == 0 )
+				pages[i] = dwRow;
+			else if ( layout == 1 )
+				pages[i] = dwLabel;
+			else if ( dwLabel >= dwLabels )
+				pages[i] = -1;
+			else
+				pages[i] = pdev->dm.dmCollate ? dwLabel % dwPages : dwLabel / dwCopies;
+		}
+
+		if ( (pageinfo = PageAdd(&rows)) == NULL )
+		{
+			Error_Log(LEVEL_ERROR, "No memory: %s\n", strerror(errno));
+			ret = 1;
+			break;
+		}
+		pageinfo->width  = nWidth;
+		pageinfo->height = nHeight;
+		pageinfo->paper_width  = (float)nWidth * 72 / pdev->dm.dmPrintQuality;
+		pageinfo->paper_length = fLength;
+
+		// The row goes as fast as its slowest label
+		for (i=0; i<N; i++)
+		{
+			pageinfo_t	*label;
+
+			if ( pages[i] >= 0 && (label = PageGet(&doc->pages, pages[i])) != NULL && label->speed
+				&& (pageinfo->speed == 0 || label->speed < pageinfo->speed) )
+				pageinfo->speed = label->speed;
+		}
+
+		// Rows of a resumed job that are printed already are not stored
+		if ( dwRow < doc->first_page )
+			pageinfo->length = 0;
+		else if ( previous && previous->length && !memcmp(pages, last, sizeof(pages)) )
+		{
+			pageinfo->offset = previous->offset;
+			pageinfo->length = previous->length;
+			pageinfo->barcodes = previous->barcodes;
+		}
+		else
+		{
+			pageinfo->offset = pdev->lib_cups.cupsFileTell(temp);
+			if ( ComposeRow(pdev, doc, temp, pages, pRow, nWidth, nHeight, xFirst, xPitch, &pageinfo->barcodes) )
+				pageinfo->length = pdev->lib_cups.cupsFileTell(temp) - pageinfo->offset;
+			else
+			{
+				Error_Log(LEVEL_ERROR, "IO error: %s\n", strerror(errno));
+				ret = 1;
+			}
+		}
+		memcpy(last, pages, sizeof(pages));
+		previous = pageinfo;
+	}
+
+	MEMFREE(pRow);
+	pdev->lib_cups.cupsFileClose(temp);
+
+	// The rows replace the pages
+	FreeDocData(pdev, doc);
+	strcpy(doc->tempfile, tempfile);
+	doc->fp_temp = fopen(doc->tempfile, "r");
+	doc->pages = rows;
+
+	Error_Log(LEVEL_INFO, "%u labels across: %u labels in %u rows of %u dots\n",
+				N, dwLabels, (dwLabels + N - 1) / N, nWidth);
+
+	pdev->dm.dmPaperWidth = (float)nWidth * 72 / pdev->dm.dmPrintQuality;
+	pdev->dm.dmPaperLength = fLength;
+	pdev->dm.dmDocPages = dwRows;
+	pdev->dm.dmCopies = layout == 0 ? dwCopies / N : layout == 1 ? dwCopies : 1;
+	pdev->dm.dmCollate = layout == 1 && dwRows > 1 ? pdev->dm.dmCollate : 0;
+
+	// A cut every n labels is a cut every n / N rows
+	if ( pdev->dm.dmOccurrence == DMOCCURRENCE_SPECIFIED )
+		pdev->dm.dmCutInterval = max((pdev->dm.dmCutInterval + N - 1) / N, 1);
+
+	return ret;
+}
+
+/*
+	Print speed of a page, black bits set. Within the box around the ink
+	the share of black dots and of dot edges, left to right and top to
+	bottom, is measured against a dense 2D barcode: such a page prints at
+	dmSpeedMin, a blank one at dmSpeedMax, in steps of 1 inch/sec.
+*/
+WORD PageSpeed(DEVDATA *pdev, const BYTE *pBits, unsigned cbRow, unsigned nHeight)
+{
+	WORD		wMax = pdev->dm.dmSpeedMax ? pdev->dm.dmSpeedMax : pdev->dm.dmPrintSpeed;
+	WORD		wMin = pdev->dm.dmSpeedMin ? pdev->dm.dmSpeedMin : SPEEDMIN_DEF_VALUE;
+	unsigned	yFirst = nHeight;
+	unsigned	yLast = 0;
+	unsigned	bFirst = cbRow;
+	unsigned	bLast = 0;
+	double		dDots = 0;
+	double		dEdges = 0;
+	double		dArea;
+	double		dScore;
+	unsigned	y;
+	unsigned	b;
+	int			nSpeed;
+
+	if ( wMax == 0 )
+		return 0;
+	wMin = min(wMin, wMax);
+
+	for (y=0; y<nHeight; y++)
+	{
+		const BYTE	*pRow = pBits + (size_t)cbRow * y;
+		const BYTE	*pPrev = y ? pRow - cbRow : NULL;
+		BYTE		left = 0;
+
+		for (b=0; b<cbRow; b++)
+		{
+			BYTE	v = pRow[b];
+
+			if ( v )
+			{
+				dDots += BITCOUNT(v);
+				yFirst = min(yFirst, y);
+				yLast = y;
+				bFirst = min(bFirst, b);
+				bLast = max(bLast, b);
+			}
+			// Each dot against the one left of it and the one above it
+			dEdges += BITCOUNT(v ^ ((v >> 1) | (BYTE)(left << 7)));
+			if ( pPrev )
+				dEdges += BITCOUNT(v ^ pPrev[b]);
+			left = v;
+		}
+	}
+
+	if ( dDots == 0 )
+		return wMax;
+
+	dArea = (double)(yLast - yFirst + 1) * (bLast - bFirst + 1) * 8;
+	dScore = max(dDots * 100 / dArea / SPEED_DENSE_INK, dEdges * 100 / dArea / SPEED_DENSE_EDGES);
+	nSpeed = (int)(wMax - min(dScore, 1) * (wMax - wMin));
+	nSpeed = max(nSpeed / 10 * 10, wMin);
+
+	DebugPrintf("PageSpeed: ink %.1f%%, edges %.1f%%, speed %d\n",
+				dDots * 100 / dArea, dEdges * 100 / dArea, nSpeed);
+	return (WORD)nSpeed;
+}
+
+// Page -1 leaves its column blank. The row is written in printer order.
+BOOL ComposeRow(DEVDATA *pdev, doc_t *doc, cups_file_t *temp, const int *pages, BYTE *pRow,
+				unsigned nWidth, unsigned nHeight, unsigned xFirst, unsigned xPitch, WORD *pwBarcodes)
+{
+	unsigned	cbRow = WIDTHBYTES_8(nWidth);
+	unsigned	i;
+	unsigned	y;
+	unsigned	b;
+	BARCODE		codes[LABELSACROSS_MAX_VALUE * BARCODE_MAX_PAGE];
+	WORD		nCodes = 0;
+
+	// Composed black on white, as the raster came
+	memset(pRow, 0, cbRow * nHeight);
+
+	for (i=0; i<doc->across; i++)
+	{
+		pageinfo_t	*pageinfo;
+		BYTE		*pSrc;
+		unsigned	cbSrc;
+		unsigned	x = xFirst + xPitch * i;
+		unsigned	shift = x & 7;
+		BYTE		mask;
+
+		if ( pages[i] < 0 )
+			continue;
+		if ( (pageinfo = PageGet(&doc->pages, pages[i])) == NULL )
+			return FALSE;
+
+		cbSrc = WIDTHBYTES_8(pageinfo->width);
+		mask = (BYTE)(0xFF << ((8 - pageinfo->width % 8) % 8));
+		if ( (pSrc = MEMALLOC(pageinfo->length)) == NULL )
+			return FALSE;
+		if ( pread(fileno(doc->fp_temp), pSrc, pageinfo->length, pageinfo->offset) != pageinfo->length )
+		{
+			MEMFREE(pSrc);
+			return FALSE;
+		}
+
+		for (y=0; y<pageinfo->height; y++)
+		{
+			BYTE	*pDst = pRow + cbRow * y + (x >> 3);
+			BYTE	*pLine = pSrc + cbSrc * y;
+
+			for (b=0; b<cbSrc; b++)
+			{
+				BYTE	v = ~pLine[b];
+
+				if ( b == cbSrc - 1 )
+					v &= mask;
+				pDst[b] |= v >> shift;
+				if ( shift && (BYTE)(v << (8 - shift)) )
+					pDst[b + 1] |= (BYTE)(v << (8 - shift));
+			}
+		}
+
+		// The symbols of the label move with it
+		for (b=0; b<pageinfo->barcodes && nCodes < sizeof(codes) / sizeof(codes[0]); b++)
+		{
+			memcpy(codes + nCodes, pSrc + cbSrc * pageinfo->height + sizeof(BARCODE) * b, sizeof(BARCODE));
+			codes[nCodes++].x += x;
+		}
+		MEMFREE(pSrc);
+	}
+
+	for (b=0; b<cbRow * nHeight; b++)
+		pRow[b] = ~pRow[b];
+
+	*pwBarcodes = nCodes;
+	if ( pdev->lib_cups.cupsFileWrite(temp, (char*)pRow, cbRow * nHeight) != cbRow * nHeight )
+		return FALSE;
+	return nCodes == 0
+		|| pdev->lib_cups.cupsFileWrite(temp, (char*)codes, sizeof(BARCODE) * nCodes) == sizeof(BARCODE) * nCodes;
+}
+
+/*
+	Code 128 and EAN symbols of a page to send as BARCODE, cleared from pBits.
+	Not on labels sized to their content: the bitmap alone sets the length.
+*/
+int PageBarcodes(DEVDATA *pdev, BYTE *pBits, unsigned cbRow, unsigned nWidth, unsigned nHeight,
+				BARCODE *pCodes)
+{
+	int		nCodes;
+
+	if ( pdev->dm.dmBarcodes != DMBARCODES_ON )
+		return 0;
+	if ( pdev->dm.dmAutoLength == DMAUTOLENGTH_ON && pdev->dm.dmMediaType == DMMEDIATYPE_CONTINUE )
+		return 0;
+
+	nCodes = BarcodeFind(pBits, cbRow, min(nWidth, cbRow * 8), nHeight, pCodes, BARCODE_MAX_PAGE);
+	if ( nCodes )
+		DebugPrintf("%d symbols sent as BARCODE\n", nCodes);
+	return nCodes;
+}
+
+/*
+	A page header is checked before anything is allocated for it. The
+	page may be up to RASTER_SIZE_FACTOR times the largest label of the
+	PPD, the part of it past the label is clipped; a larger one is not
+	read row by row for nothing.
+*/
+BOOL CheckRasterHeader(DEVDATA *pdev, cups_page_header_t *header)
+{
+	float		fMaxWidth = pdev->ppd->custom_max[0];
+	float		fMaxLength = pdev->ppd->custom_max[1];
+	double		dMaxWidth;
+	double		dMaxHeight;
+	int			i;
+
+	for (i=0; i<pdev->ppd->num_sizes; i++)
+	{
+		fMaxWidth = max(fMaxWidth, pdev->ppd->sizes[i].width);
+		fMaxLength = max(fMaxLength, pdev->ppd->sizes[i].length);
+	}
+
+	if ( header->cupsBitsPerPixel != 1 )
+	{
+		Error_Log(LEVEL_ERROR, "Raster of %u bits per pixel, 1 expected\n", header->cupsBitsPerPixel);
+		return FALSE;
+	}
+	if ( header->HWResolution[0] == 0 || header->HWResolution[0] > RASTER_MAX_RESOLUTION
+		|| header->HWResolution[1] == 0 || header->HWResolution[1] > RASTER_MAX_RESOLUTION )
+	{
+		Error_Log(LEVEL_ERROR, "Raster resolution %ux%u dpi\n", header->HWResolution[0], header->HWResolution[1]);
+		return FALSE;
+	}
+
+	dMaxWidth = (double)fMaxWidth * RASTER_SIZE_FACTOR * header->HWResolution[0] / 72;
+	dMaxHeight = (double)fMaxLength * RASTER_SIZE_FACTOR * header->HWResolution[1] / 72;
+	if ( fMaxWidth > 0 && fMaxLength > 0 && (header->cupsWidth > dMaxWidth || header->cupsHeight > dMaxHeight) )
+	{
+		Error_Log(LEVEL_ERROR, "Raster of %ux%u dots, the printer takes %.0fx%.0f points\n",
+					header->cupsWidth, header->cupsHeight, fMaxWidth, fMaxLength);
+		return FALSE;
+	}
+	return TRUE;
+}
+
 void FreeDocData(DEVDATA *pdev, doc_t *doc)
 {
 	if ( doc->fp_temp )
 		fclose(doc->fp_temp);
 	if ( doc->tempfile[0] )
 		unlink(doc->tempfile);
+	PageFree(&doc->pages);
+}
+
+/*
+	The page index holds the pages in chunks, it grows without moving
+	them and costs sizeof(pageinfo_t) a page, no allocation of its own.
+*/
+pageinfo_t* PageAdd(pageindex_t *index)
+{
+	DWORD		dwChunk = index->count / PAGEINDEX_CHUNK;
+
+	if ( dwChunk >= index->alloc )
+	{
+		DWORD		dwAlloc = index->alloc ? index->alloc * 2 : 16;
+		pageinfo_t	**chunks = realloc(index->chunks, dwAlloc * sizeof(pageinfo_t*));
+
+		if ( chunks == NULL )
+			return NULL;
+		memset(chunks + index->alloc, 0, (dwAlloc - index->alloc) * sizeof(pageinfo_t*));
+		index->chunks = chunks;
+		index->alloc = dwAlloc;
+	}
+	if ( index->chunks[dwChunk] == NULL
+		&& (index->chunks[dwChunk] = MEMALLOC(PAGEINDEX_CHUNK * sizeof(pageinfo_t))) == NULL )
+		return NULL;
+
+	return index->chunks[dwChunk] + index->count++ % PAGEINDEX_CHUNK;
+}
+
+pageinfo_t* PageGet(pageindex_t *index, DWORD dwPage)
+{
+	if ( dwPage >= index->count )
+		return NULL;
+	return index->chunks[dwPage / PAGEINDEX_CHUNK] + dwPage % PAGEINDEX_CHUNK;
+}
+
+void PageFree(pageindex_t *index)
+{
+	DWORD		i;
+
+	for (i=0; i<index->alloc; i++)
+		MEMFREE(index->chunks[i]);
+	MEMFREE(index->chunks);
+	memset(index, 0, sizeof(pageindex_t));
+}
+
+BOOL SessionConnect(DEVDATA *pdev)
+{
+	int				fd;
+	char			szSocket[256];
+	SESSIONHEADER	header;
+
+	snprintf(szSocket, sizeof(szSocket), TSC_SESSION_SOCKET, pdev->szPrinterName);
+	if ( (fd = NetOpenUnixSocket(szSocket)) < 0 )
+	{
+		Error_Log(LEVEL_INFO, "Label session service not available, print directly\n");
+		return FALSE;
+	}
+
+	memset(&header, 0, sizeof(header));
+	header.shMarker = SESSION_HEADER_MARKER;
+	header.shSize = sizeof(header);
+	memcpy(&header.shDevmode, &pdev->dm, sizeof(DEVMODE));
+	header.shDevmode.dmType = DM_HEADER_MARKER;
+	header.shDevmode.dmSize = sizeof(DEVMODE);
+	header.shDevmode.dmSizeExtra = 0;
+
+	// Nothing is written yet, so a failure here can still fall back to stdout
+	if ( NetWriteAll(fd, &header, sizeof(header)) != sizeof(header) || dup2(fd, fileno(stdout)) < 0 )
+	{
+		Error_Log(LEVEL_WARNING, "Unable to send job to label session service: %s\n", strerror(errno));
+		close(fd);
+		return FALSE;
+	}
+	close(fd);
+
+	DebugPrintf("Job handed to label session service %s\n", szSocket);
+	return TRUE;
+}
+
+BOOL SessionDisconnect(DEVDATA *pdev)
+{
+	SESSIONTRAILER	trailer;
+	SESSIONREPLY	reply;
+	ssize_t			nBytes;
+	size_t			nReaded = 0;
+
+	memset(&trailer, 0, sizeof(trailer));
+	trailer.stMarker = SESSION_TRAILER_MARKER;
+	if ( NetWriteAll(fileno(stdout), &trailer, sizeof(trailer)) != sizeof(trailer)
+		|| shutdown(fileno(stdout), SHUT_WR) )
+	{
+		Error_Log(LEVEL_ERROR, "Unable to send job to label session service: %s\n", strerror(errno));
+		return FALSE;
+	}
+
+	// The service answers once the job went out to the printer, or did not
+	while ( nReaded < sizeof(reply) )
+	{
+		nBytes = read(fileno(stdout), (BYTE*)&reply + nReaded, sizeof(reply) - nReaded);
+		if ( nBytes < 0 && errno == EINTR )
+			continue;
+		if ( nBytes <= 0 )
+			break;
+		nReaded += nBytes;
+	}
+
+	if ( nReaded != sizeof(reply) || reply.srMarker != SESSION_REPLY_MARKER )
+	{
+		Error_Log(LEVEL_ERROR, "No reply from label session service\n");
+		return FALSE;
+	}
+	switch ( reply.srStatus )
+	{
+	case SESSION_STATUS_OK:
+		return TRUE;
+	case SESSION_STATUS_INVALID:
+		Error_Log(LEVEL_ERROR, "Job rejected by label session service\n");
+		break;
+	default:
+		Error_Log(LEVEL_ERROR, "Label session service could not send the job to the printer\n");
+		break;
+	}
+	return FALSE;
 }
 
 DEVDATA* DrvEnable(int argc, char *argv[])
@@ -604,8 +1854,18 @@ static BOOL bInitCupsOptions(DEVDATA *pdev, char *argv[])
 
 size_t printer_write(const void* pbuf, size_t cbbuf)
 {
+#ifdef HAVE_SYS_SDT_H
+	double		dStart = GetSeconds();
+#endif
+	ssize_t		nBytes;
+
 //	DebugPrintf("printer_write %d bytes\n", cbbuf);
-	return write(fileno(stdout), pbuf, cbbuf);
+	JobCacheWrite(pbuf, cbbuf);
+	nBytes = write(fileno(stdout), pbuf, cbbuf);
+#ifdef HAVE_SYS_SDT_H
+	TSC_PROBE3(output__write, cbbuf, nBytes, (long)((GetSeconds() - dStart) * 1000000));
+#endif
+	return nBytes;
 }
 
 int printer_printf(const char* strfmt, ...)
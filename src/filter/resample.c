@@ -0,0 +1,220 @@
+/*
+ * "resample.c 2026-10-17 10:12:40
+ *
+ *  1bpp resolution conversion routines for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+/*
+	Area coverage: a printer dot is black when at least half of the area
+	it covers on the page is black in the source.
+
+	Positions are counted in units of 1 / (in dpi * out dpi) inch, where
+	source dot i spans [i * out, (i + 1) * out) and printer dot X spans
+	[X * in, (X + 1) * in), so every overlap is an exact integer. Each
+	source row adds its coverage to the printer rows it overlaps, a row is
+	thresholded as soon as no later source row reaches it.
+*/
+
+#include "config.h"
+#include "common.h"
+#include "resample.h"
+
+#define	RESAMPLE_THRESHOLD			50		// % of a dot covered to print it
+
+typedef struct _RESAMPLECOLUMN
+{
+	unsigned	i0;						// First source dot
+	unsigned	i1;						// Last source dot
+	DWORD		w0;						// Part of i0 covered, i1 and dots between
+	DWORD		w1;						// are covered in full
+} RESAMPLECOLUMN;
+
+struct _RESAMPLE
+{
+	unsigned		nSrcWidth;
+	unsigned		nSrcHeight;
+	unsigned		nWidth;
+	unsigned		nHeight;
+	DWORD			dwInY;
+	DWORD			dwOutX;
+	DWORD			dwOutY;
+	DWORD			dwThreshold;		// Coverage of a black printer dot
+	size_t			cbDst;
+	RESAMPLECOLUMN	*pColumns;
+	DWORD			*pCover;			// Source row coverage per printer dot
+	DWORD			*pAcc;				// nWindow printer rows being covered
+	unsigned		nWindow;
+	unsigned		ySrc;				// Next source row
+	unsigned		yDst;				// First printer row not written
+};
+
+static DWORD CountDots(const BYTE *pRow, unsigned nWidth, unsigned a, unsigned b);
+static void ResampleEmit(RESAMPLE *pRes, BYTE *pDst);
+
+RESAMPLE* ResampleCreate(unsigned nWidth, unsigned nHeight, DWORD dwInX, DWORD dwInY, DWORD dwOutX, DWORD dwOutY)
+{
+	RESAMPLE	*pRes;
+	unsigned	X;
+
+	if ( nWidth == 0 || nHeight == 0 || dwInX == 0 || dwInY == 0 || dwOutX == 0 || dwOutY == 0 )
+		return NULL;
+	if ( (pRes = MEMALLOC(sizeof(RESAMPLE))) == NULL )
+		return NULL;
+
+	pRes->nSrcWidth = nWidth;
+	pRes->nSrcHeight = nHeight;
+	pRes->nWidth = max(1, (unsigned)(((double)nWidth * dwOutX + dwInX / 2) / dwInX));
+	pRes->nHeight = max(1, (unsigned)(((double)nHeight * dwOutY + dwInY / 2) / dwInY));
+	pRes->dwInY = dwInY;
+	pRes->dwOutX = dwOutX;
+	pRes->dwOutY = dwOutY;
+	pRes->dwThreshold = (DWORD)(((double)dwInX * dwInY * RESAMPLE_THRESHOLD + 99) / 100);
+	pRes->cbDst = WIDTHBYTES_8(pRes->nWidth);
+	pRes->nWindow = dwOutY / dwInY + 2;
+
+	pRes->pColumns = MEMALLOC(sizeof(RESAMPLECOLUMN) * pRes->nWidth);
+	pRes->pCover = MEMALLOC(sizeof(DWORD) * pRes->nWidth);
+	pRes->pAcc = MEMALLOC(sizeof(DWORD) * pRes->nWidth * pRes->nWindow);
+	if ( pRes->pColumns == NULL || pRes->pCover == NULL || pRes->pAcc == NULL )
+	{
+		ResampleDestroy(pRes);
+		return NULL;
+	}
+
+	for (X = 0; X < pRes->nWidth; X++)
+	{
+		RESAMPLECOLUMN	*pCol = pRes->pColumns + X;
+		double			lo = (double)X * dwInX;
+		double			hi = lo + dwInX;
+
+		pCol->i0 = (unsigned)(lo / dwOutX);
+		pCol->i1 = (unsigned)((hi - 1) / dwOutX);
+		if ( pCol->i0 == pCol->i1 )
+			pCol->w0 = dwInX;
+		else
+		{
+			pCol->w0 = (DWORD)((pCol->i0 + 1.0) * dwOutX - lo);
+			pCol->w1 = (DWORD)(hi - (double)pCol->i1 * dwOutX);
+		}
+	}
+
+	return pRes;
+}
+
+void ResampleDestroy(RESAMPLE *pRes)
+{
+	if ( pRes == NULL )
+		return;
+	MEMFREE(pRes->pColumns);
+	MEMFREE(pRes->pCover);
+	MEMFREE(pRes->pAcc);
+	MEMFREE(pRes);
+}
+
+unsigned ResampleWidth(RESAMPLE *pRes)
+{
+	return pRes->nWidth;
+}
+
+unsigned ResampleHeight(RESAMPLE *pRes)
+{
+	return pRes->nHeight;
+}
+
+void ResampleRow(RESAMPLE *pRes, const BYTE *pSrc, BYTE *pDst)
+{
+	double		lo = (double)pRes->ySrc * pRes->dwOutY;
+	double		hi = lo + pRes->dwOutY;
+	unsigned	Y0 = (unsigned)(lo / pRes->dwInY);
+	unsigned	Y1 = min((unsigned)((hi - 1) / pRes->dwInY), pRes->nHeight - 1);
+	unsigned	X, Y;
+
+	if ( pRes->ySrc >= pRes->nSrcHeight )
+		return;
+	pRes->ySrc ++;
+
+	// A blank row adds nothing, most rows of a label are blank
+	if ( CountDots(pSrc, pRes->nSrcWidth, 0, pRes->nSrcWidth) )
+	{
+		for (X = 0; X < pRes->nWidth; X++)
+		{
+			RESAMPLECOLUMN	*pCol = pRes->pColumns + X;
+
+			if ( pCol->i0 == pCol->i1 )
+				pRes->pCover[X] = CountDots(pSrc, pRes->nSrcWidth, pCol->i0, pCol->i0 + 1) * pCol->w0;
+			else
+				pRes->pCover[X] = CountDots(pSrc, pRes->nSrcWidth, pCol->i0, pCol->i0 + 1) * pCol->w0
+								+ CountDots(pSrc, pRes->nSrcWidth, pCol->i0 + 1, pCol->i1) * pRes->dwOutX
+								+ CountDots(pSrc, pRes->nSrcWidth, pCol->i1, pCol->i1 + 1) * pCol->w1;
+		}
+
+		for (Y = Y0; Y <= Y1; Y++)
+		{
+			DWORD	*pAcc = pRes->pAcc + (size_t)pRes->nWidth * (Y % pRes->nWindow);
+			DWORD	dwOverlap = (DWORD)(min(hi, (Y + 1.0) * pRes->dwInY) - max(lo, (double)Y * pRes->dwInY));
+
+			for (X = 0; X < pRes->nWidth; X++)
+				pAcc[X] += pRes->pCover[X] * dwOverlap;
+		}
+	}
+
+	// Rows no later source row reaches
+	while ( pRes->yDst < pRes->nHeight && (pRes->yDst + 1.0) * pRes->dwInY <= hi )
+		ResampleEmit(pRes, pDst);
+}
+
+// Rows past the last source row are covered in part only
+void ResampleEnd(RESAMPLE *pRes, BYTE *pDst)
+{
+	while ( pRes->yDst < pRes->nHeight )
+		ResampleEmit(pRes, pDst);
+}
+
+void ResampleEmit(RESAMPLE *pRes, BYTE *pDst)
+{
+	DWORD		*pAcc = pRes->pAcc + (size_t)pRes->nWidth * (pRes->yDst % pRes->nWindow);
+	BYTE		*pRow = pDst + pRes->cbDst * pRes->yDst;
+	unsigned	X;
+
+	memset(pRow, 0, pRes->cbDst);
+	for (X = 0; X < pRes->nWidth; X++)
+	{
+		if ( pAcc[X] >= pRes->dwThreshold )
+			pRow[X >> 3] |= 0x80 >> (X & 7);
+		pAcc[X] = 0;
+	}
+	pRes->yDst ++;
+}
+
+// Black dots in [a, b) of a row of nWidth dots
+DWORD CountDots(const BYTE *pRow, unsigned nWidth, unsigned a, unsigned b)
+{
+	DWORD		n;
+	unsigned	i;
+
+	b = min(b, nWidth);
+	if ( a >= b )
+		return 0;
+
+	if ( a >> 3 == (b - 1) >> 3 )
+		return BITCOUNT(pRow[a >> 3] & (0xFF >> (a & 7)) & (BYTE)(0xFF << (7 - ((b - 1) & 7))));
+
+	n = BITCOUNT(pRow[a >> 3] & (0xFF >> (a & 7)));
+	for (i = (a >> 3) + 1; i < (b - 1) >> 3; i++)
+		n += BITCOUNT(pRow[i]);
+	return n + BITCOUNT(pRow[(b - 1) >> 3] & (BYTE)(0xFF << (7 - ((b - 1) & 7))));
+}
@@ -0,0 +1,40 @@
+/*
+ * "resample.h 2026-10-17 10:12:40
+ *
+ *  1bpp resolution conversion declaration for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#ifndef _RESAMPLE_H_
+#define _RESAMPLE_H_
+
+#include "common.h"
+
+typedef struct _RESAMPLE RESAMPLE;
+
+// Rows of nWidth x nHeight dots at dwInX x dwInY dpi, set bit = black,
+// to dwOutX x dwOutY dpi. The size of the result is known from the start.
+RESAMPLE*	ResampleCreate(unsigned nWidth, unsigned nHeight, DWORD dwInX, DWORD dwInY, DWORD dwOutX, DWORD dwOutY);
+void		ResampleDestroy(RESAMPLE *pRes);
+unsigned	ResampleWidth(RESAMPLE *pRes);
+unsigned	ResampleHeight(RESAMPLE *pRes);
+
+// Source rows one by one, top down. Finished rows are written to pDst,
+// WIDTHBYTES_8(ResampleWidth()) bytes each, the last ones by ResampleEnd().
+void		ResampleRow(RESAMPLE *pRes, const BYTE *pSrc, BYTE *pDst);
+void		ResampleEnd(RESAMPLE *pRes, BYTE *pDst);
+
+#endif	// #ifndef _RESAMPLE_H_
@@ -0,0 +1,75 @@
+/*
+ * "session.h 2026-10-17 10:12:40
+ *
+ *  label session protocol declaration for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#ifndef _SESSION_H_
+#define _SESSION_H_
+
+#include "devmode.h"
+
+/*
+	A filter hands a job to tsplsessiond as:
+
+		SESSIONHEADER		(printer setup of the job)
+		TSPL page data		(CLS ... PRINT for every label, no job preamble)
+		SESSIONTRAILER		(marks a complete job)
+
+	and waits for the SESSIONREPLY of the service, which tells whether the
+	job went out to the printer. The filter returns that to CUPS.
+
+	The service owns the printer connection and the job preamble. Jobs with
+	the same setup that arrive within the coalesce window are appended to the
+	open TSPL stream instead of starting a new one.
+*/
+
+#define TSC_SESSION_DIR				"/var/run/tsc"
+#define TSC_SESSION_SOCKET			TSC_SESSION_DIR "/%s.sock"		// by printer name
+
+#define SESSION_HEADER_MARKER		0x31535354		// "TSS1"
+#define SESSION_TRAILER_MARKER		0x45535354		// "TSSE"
+#define SESSION_REPLY_MARKER		0x52535354		// "TSSR"
+
+#define SESSION_STATUS_OK			0				// Job sent to the printer
+#define SESSION_STATUS_INVALID		1				// Job rejected, nothing sent
+#define SESSION_STATUS_FAILED		2				// Printer not reached or write error
+
+#define SESSION_DEFAULT_WINDOW		2000			// ms
+#define SESSION_READ_TIMEOUT		30				// Second, longest a client may stall
+#define SESSION_GROUP				"lp"			// Group of the CUPS filters, may use the socket
+
+typedef struct _SESSIONHEADER
+{
+	DWORD	shMarker;				// SESSION_HEADER_MARKER
+	DWORD	shSize;					// sizeof(SESSIONHEADER)
+	DEVMODE	shDevmode;
+} SESSIONHEADER;
+
+typedef struct _SESSIONTRAILER
+{
+	DWORD	stMarker;				// SESSION_TRAILER_MARKER
+	DWORD	stReserved;
+} SESSIONTRAILER;
+
+typedef struct _SESSIONREPLY
+{
+	DWORD	srMarker;				// SESSION_REPLY_MARKER
+	DWORD	srStatus;				// SESSION_STATUS_*
+} SESSIONREPLY;
+
+#endif	// #ifndef _SESSION_H_
@@ -0,0 +1,342 @@
+/*
+ * "status.c 2026-10-17 10:12:40
+ *
+ *  printer status polling routines for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+/*
+	Before every label the printer is asked for its status with <ESC>!?
+	over the CUPS back channel, or over the connection of a pool printer. While it reports an error the job waits
+	and the error is shown as a printer-state-reason.
+
+	The printer cannot tell how much of its buffer is used, so labels are
+	paced by an estimate: every label sent is expected to be printed
+	(paper length + gap) / speed after the previous one. No more than
+	STATUS_PACING_BUFFER bytes are sent ahead of that estimate, and the
+	estimate is dropped whenever the printer says it is idle.
+*/
+
+#include "config.h"
+#include "common.h"
+#include "debug.h"
+#include "status.h"
+
+#include <poll.h>
+#include <sys/time.h>
+
+#define	STATUS_QUEUE_SIZE			256		// Labels tracked ahead of the print head
+#define	STATUS_DEFAULT_SPEED		40		// 1/10 inch/sec, when the job sets none
+
+#define	STATUS_BLOCKING		(TSPL_STATUS_HEAD_OPEN | TSPL_STATUS_PAPER_JAM | TSPL_STATUS_PAPER_EMPTY \
+							| TSPL_STATUS_RIBBON_EMPTY | TSPL_STATUS_PAUSE | TSPL_STATUS_COVER_OPEN)
+
+typedef struct _LABELQUEUED
+{
+	double		dFinish;					// Estimated time the label is printed
+	size_t		cbLabel;
+	DWORD		dwCopies;
+} LABELQUEUED;
+
+typedef struct _PRINTERSTATUS
+{
+	BOOL		bEnable;
+	int			fdReply;					// Printer connection, < 0 for the CUPS back channel
+	BYTE		bReported;					// Status bits shown as state reasons
+	double		dLabelTime;					// Seconds to print one label
+	size_t		cbQueued;
+	int			nFirst;
+	int			nCount;
+	LABELQUEUED	queue[STATUS_QUEUE_SIZE];
+} PRINTERSTATUS;
+
+static const struct
+{
+	BYTE		bStatus;
+	const char	*szReason;
+	const char	*szMessage;
+} g_StatusReasons[] =
+{
+	{ TSPL_STATUS_HEAD_OPEN,		"cover-open-error",				"Print head open" },
+	{ TSPL_STATUS_PAPER_JAM,		"media-jam-error",				"Paper jam" },
+	{ TSPL_STATUS_PAPER_EMPTY,		"media-empty-error",			"Out of paper" },
+	{ TSPL_STATUS_RIBBON_EMPTY,		"marker-supply-empty-error",	"Out of ribbon" },
+	{ TSPL_STATUS_PAUSE,			"paused",						"Printer paused" },
+	{ TSPL_STATUS_COVER_OPEN,		"door-open-error",				"Cover open" },
+	{ TSPL_STATUS_TEMPERATURE,		"other-warning",				"Print head temperature out of range" },
+};
+
+static PRINTERSTATUS	g_status;
+
+ssize_t TSPL_WriteControl(const void *pbuf, size_t cbbuf);
+
+static int StatusQuery(DEVDATA *pdev);
+static ssize_t StatusRead(DEVDATA *pdev, void *buffer, size_t bytes, double timeout);
+static void StatusReport(BYTE bStatus);
+static double StatusNow(void);
+
+void PrinterStatusInit(DEVDATA *pdev, int fdReply)
+{
+	WORD	wSpeed = STATUS_DEFAULT_SPEED;
+
+	memset(&g_status, 0, sizeof(g_status));
+	g_status.fdReply = fdReply;
+
+	if ( pdev->dm.dmStatusPolling != DMSTATUSPOLLING_ON )
+		return;
+	if ( fdReply < 0 && pdev->lib_cups.cupsBackChannelRead == NULL )
+	{
+		Error_Log(LEVEL_INFO, "No CUPS back channel, printer status polling off\n");
+		return;
+	}
+
+	if ( (pdev->dm.dmFields & DM_PRINTSPEED) && pdev->dm.dmPrintSpeed )
+		wSpeed = pdev->dm.dmPrintSpeed;
+	g_status.dLabelTime = POINT2INCH((double)pdev->dm.dmPaperLength + pdev->dm.dmGapHeight) * 10 / wSpeed;
+	g_status.bEnable = TRUE;
+
+	if ( StatusQuery(pdev) < 0 )
+	{
+		Error_Log(LEVEL_INFO, "Printer does not report status, printer status polling off\n");
+		g_status.bEnable = FALSE;
+	}
+	DebugPrintf("PrinterStatusInit: %s, %.3f sec/label\n", g_status.bEnable ? "on" : "off", g_status.dLabelTime);
+}
+
+// Called before a label of cbLabel bytes, printed dwCopies times, is sent.
+void PrinterStatusWait(DEVDATA *pdev, size_t cbLabel, DWORD dwCopies)
+{
+	int			nStatus;
+	double		dNow;
+	double		dStart;
+	double		dStall = 0;
+	int			nTimeouts = 0;
+	int			i;
+
+	if ( !g_status.bEnable )
+		return;
+
+	while (1)
+	{
+		// A stalled printer may not read the request behind the queued data
+		if ( (nStatus = StatusQuery(pdev)) < 0 )
+		{
+			if ( ++nTimeouts < STATUS_MAX_TIMEOUTS )
+			{
+				dStall += STATUS_REPLY_TIMEOUT;
+				continue;
+			}
+			Error_Log(LEVEL_WARNING, "Printer stopped answering status requests, printer status polling off\n");
+			StatusReport(0);
+			g_status.bEnable = FALSE;
+			return;
+		}
+		nTimeouts = 0;
+		StatusReport(nStatus);
+
+		if ( nStatus & STATUS_BLOCKING )
+		{
+			sleep(STATUS_RETRY_INTERVAL);
+			dStall += STATUS_RETRY_INTERVAL;
+			continue;
+		}
+
+		dNow = StatusNow();
+
+		// Nothing printed while the printer was stopped
+		if ( dStall > 0 )
+		{
+			for (i=0; i<g_status.nCount; i++)
+				g_status.queue[(g_status.nFirst + i) % STATUS_QUEUE_SIZE].dFinish += dStall;
+			dStall = 0;
+		}
+
+		// Idle printer, everything sent so far is done or still on the way
+		if ( !(nStatus & TSPL_STATUS_PRINTING) )
+		{
+			g_status.nCount = 0;
+			g_status.cbQueued = 0;
+		}
+
+		while ( g_status.nCount > 0 && g_status.queue[g_status.nFirst].dFinish <= dNow )
+		{
+			g_status.cbQueued -= g_status.queue[g_status.nFirst].cbLabel;
+			g_status.nFirst = (g_status.nFirst + 1) % STATUS_QUEUE_SIZE;
+			g_status.nCount --;
+		}
+
+		if ( g_status.nCount == 0
+			|| (g_status.nCount < STATUS_QUEUE_SIZE && g_status.cbQueued + cbLabel <= STATUS_PACING_BUFFER) )
+			break;
+
+		// Printer buffer is full enough, wait for the oldest label
+		usleep((useconds_t)(min(g_status.queue[g_status.nFirst].dFinish - dNow, 0.5) * 1000000));
+	}
+
+	dStart = dNow;
+	if ( g_status.nCount > 0 )
+		dStart = max(dNow, g_status.queue[(g_status.nFirst + g_status.nCount - 1) % STATUS_QUEUE_SIZE].dFinish);
+
+	i = (g_status.nFirst + g_status.nCount) % STATUS_QUEUE_SIZE;
+	g_status.queue[i].dFinish = dStart + g_status.dLabelTime * dwCopies;
+	g_status.queue[i].cbLabel = cbLabel;
+	g_status.queue[i].dwCopies = dwCopies;
+	g_status.cbQueued += cbLabel;
+	g_status.nCount ++;
+}
+
+// Labels sent that the printer is not expected to have printed yet
+DWORD PrinterStatusPending(void)
+{
+	DWORD	dwPending = 0;
+	int		i;
+
+	if ( !g_status.bEnable )
+		return 0;
+
+	for (i=0; i<g_status.nCount; i++)
+	{
+		LABELQUEUED	*plabel = &g_status.queue[(g_status.nFirst + i) % STATUS_QUEUE_SIZE];
+
+		if ( plabel->dFinish > StatusNow() )
+			dwPending += plabel->dwCopies;
+	}
+	return dwPending;
+}
+
+// Waits until the printer is idle after the last label. FALSE when the
+// end of the job is not confirmed, without polling it cannot be.
+BOOL PrinterStatusDrain(DEVDATA *pdev)
+{
+	int			nStatus;
+	int			nTimeouts = 0;
+	double		dLast;
+	double		dStall = 0;
+
+	if ( !g_status.bEnable )
+		return TRUE;
+
+	dLast = StatusNow();
+	if ( g_status.nCount > 0 )
+		dLast = max(dLast, g_status.queue[(g_status.nFirst + g_status.nCount - 1) % STATUS_QUEUE_SIZE].dFinish);
+
+	while (1)
+	{
+		if ( (nStatus = StatusQuery(pdev)) < 0 )
+		{
+			if ( ++nTimeouts < STATUS_MAX_TIMEOUTS )
+				continue;
+			Error_Log(LEVEL_WARNING, "Printer stopped answering status requests, end of job not confirmed\n");
+			return FALSE;
+		}
+		nTimeouts = 0;
+		StatusReport(nStatus);
+
+		// Nothing printed while the printer is stopped
+		if ( nStatus & STATUS_BLOCKING )
+		{
+			sleep(STATUS_RETRY_INTERVAL);
+			dStall += STATUS_RETRY_INTERVAL;
+			continue;
+		}
+		if ( !(nStatus & TSPL_STATUS_PRINTING) )
+		{
+			g_status.nCount = 0;
+			g_status.cbQueued = 0;
+			return TRUE;
+		}
+		if ( StatusNow() > dLast + dStall + STATUS_DRAIN_SLACK )
+		{
+			Error_Log(LEVEL_WARNING, "Printer still printing %d seconds after the job, end of job not confirmed\n",
+						STATUS_DRAIN_SLACK);
+			return FALSE;
+		}
+		usleep(500000);
+	}
+}
+
+void PrinterStatusEnd(DEVDATA *pdev)
+{
+	StatusReport(0);
+	g_status.bEnable = FALSE;
+}
+
+int StatusQuery(DEVDATA *pdev)
+{
+	char	buffer[64];
+	BYTE	bStatus;
+
+	// Drop replies nobody waited for
+	while ( StatusRead(pdev, buffer, sizeof(buffer), 0.0) > 0 )
+		;
+
+	// Not part of the job output, so not in the job cache
+	if ( TSPL_WriteControl("\x1b!?", 3) != 3 )
+		return -1;
+	if ( StatusRead(pdev, &bStatus, 1, STATUS_REPLY_TIMEOUT) != 1 )
+		return -1;
+
+	return bStatus;
+}
+
+ssize_t StatusRead(DEVDATA *pdev, void *buffer, size_t bytes, double timeout)
+{
+	struct pollfd	pfd;
+	ssize_t			nBytes;
+
+	if ( g_status.fdReply < 0 )
+		return pdev->lib_cups.cupsBackChannelRead(buffer, bytes, timeout);
+
+	pfd.fd = g_status.fdReply;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	if ( poll(&pfd, 1, (int)(timeout * 1000)) <= 0 )
+		return -1;
+
+	while ( (nBytes = read(g_status.fdReply, buffer, bytes)) < 0 && errno == EINTR )
+		;
+	return nBytes;
+}
+
+// Show newly set bits as printer-state-reasons and clear the others.
+void StatusReport(BYTE bStatus)
+{
+	int		i;
+
+	for (i=0; i<ARRAYCOUNT(g_StatusReasons); i++)
+	{
+		BYTE	bBit = g_StatusReasons[i].bStatus;
+
+		if ( (bStatus & bBit) && !(g_status.bReported & bBit) )
+		{
+			fprintf(stderr, "STATE: +%s\n", g_StatusReasons[i].szReason);
+			Error_Log(LEVEL_INFO, "%s\n", g_StatusReasons[i].szMessage);
+		}
+		else if ( !(bStatus & bBit) && (g_status.bReported & bBit) )
+		{
+			fprintf(stderr, "STATE: -%s\n", g_StatusReasons[i].szReason);
+		}
+	}
+	g_status.bReported = bStatus & ~TSPL_STATUS_PRINTING;
+}
+
+double StatusNow(void)
+{
+	struct timeval	tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
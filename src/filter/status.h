@@ -0,0 +1,48 @@
+/*
+ * "status.h 2026-10-17 10:12:40
+ *
+ *  printer status polling declaration for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#ifndef _STATUS_H_
+#define _STATUS_H_
+
+#include "device.h"
+
+// Reply of <ESC>!?
+#define	TSPL_STATUS_HEAD_OPEN		0x01
+#define	TSPL_STATUS_PAPER_JAM		0x02
+#define	TSPL_STATUS_PAPER_EMPTY		0x04
+#define	TSPL_STATUS_RIBBON_EMPTY	0x08
+#define	TSPL_STATUS_PAUSE			0x10
+#define	TSPL_STATUS_PRINTING		0x20
+#define	TSPL_STATUS_COVER_OPEN		0x40
+#define	TSPL_STATUS_TEMPERATURE		0x80
+
+#define	STATUS_REPLY_TIMEOUT		3.0					// sec
+#define	STATUS_MAX_TIMEOUTS			10					// Unanswered requests before polling is given up
+#define	STATUS_RETRY_INTERVAL		2					// sec, while the printer is in error
+#define	STATUS_PACING_BUFFER		(256 * 1024)		// Bytes queued ahead of the print head
+#define	STATUS_DRAIN_SLACK			60					// sec, printing past the estimate before the end is not confirmed
+
+void	PrinterStatusInit(DEVDATA *pdev, int fdReply);		// fdReply < 0: CUPS back channel
+void	PrinterStatusWait(DEVDATA *pdev, size_t cbLabel, DWORD dwCopies);
+DWORD	PrinterStatusPending(void);
+BOOL	PrinterStatusDrain(DEVDATA *pdev);
+void	PrinterStatusEnd(DEVDATA *pdev);
+
+#endif	// #ifndef _STATUS_H_
@@ -24,317 +24,101 @@
 #include "debug.h"
 #include "devmode.h"
 #include "device.h"
+#include "netio.h"
+#include "uring.h"
+#include "tsplenc.h"
+#include "jobcache.h"
+#include "probe.h"
 #include <stdarg.h>
+#include <time.h>
 
-#define	DRAWMODE_COPY			0
-#define	DRAWMODE_OR				1
-#define	DRAWMODE_XOR			2
-
-#define DIRECTION_RIGHT_BOTTOM	0
-#define DIRECTION_LEFT_TOP		1
-
+/*
+	The filters print through libtsplenc, one job at a time to stdout.
+	The printer setup is kept in a file per queue between jobs.
 
-#define	TSPL_SET_TEAR				"SET TEAR %s\r\n"
-#define	TSPL_SET_PEEL				"SET PEEL %s\r\n"
-#define	TSPL_SET_CUTTER				"SET CUTTER %s\r\n"
-#define	TSPL_SET_PARTIAL_CUTTER		"SET PARTIAL_CUTTER %s\r\n"
+	With dmAsyncIO the output is written behind through io_uring and is
+	all out at the end of the job.
+*/
 
-static size_t printer_write(const void* pbuf, size_t cbbuf);
-static size_t printer_puts(const char* str);
-static int printer_printf(const char* strfmt, ...);
+// Printer setup state of the queue, kept between jobs
+#define	SETUP_STATE_DIR				"/var/cache/cups"
+#define	SETUP_STATE_FILE			"%s/tsc-%s.setup"		// by cache dir, printer name
+#define	SETUP_STATE_MARKER			"TSCSETUP"
 
-static int TSPL_SendBitmap1bpp(DEVMODE *pdm, BITMAPINFOHEADER* pBih, void* pBits);
-static int TSPL_SendUserCommand(DEVMODE *pdm, DWORD dwField);
+typedef struct _SETUPSTATE
+{
+	BOOL		bEnable;				// Cache is used for this job
+	char		szFile[256];
+	TSPLSETUP	setup;
+} SETUPSTATE;
+
+static SETUPSTATE	g_setup;
+static TSPLJOB		*g_pJob;			// Job of this process, on stdout
+static URINGOUT		*g_pUring;			// dmAsyncIO, NULL for blocking writes
+static double		g_dWriteTime;		// Seconds blocked writing to stdout
+static double		g_dWriteBytes;
+
+static TSPLJOB* TSPL_Job(DEVMODE *pdm);
+static ssize_t StdoutWrite(void *pContext, const void *pbuf, size_t cbbuf);
+static ssize_t StdoutSendFile(void *pContext, int fd, off_t offset, size_t count);
+static void SetupStateLoad(DEVMODE *pdm);
+static void SetupStateSave(void);
 
 int TSPL_SendJobStart(DEVMODE *pdm)
 {
-	// Set User Command - Start Job
-	TSPL_SendUserCommand(pdm, DM_CMDSTARTJOB);
+	SetupStateLoad(pdm);
 
-	// Set Lable Size
-	if ( pdm->dmMetric == DMMETRIC_INCH )
-		printer_printf("SIZE %.3f,%.3f\r\n", POINT2INCH(pdm->dmPaperWidth), POINT2INCH(pdm->dmPaperLength));
-	else
-		printer_printf("SIZE %.1f mm,%.1f mm\r\n", POINT2MM(pdm->dmPaperWidth), POINT2MM(pdm->dmPaperLength));
+	// A new job, with or without the printer setup
+	TsplJobDestroy(g_pJob);
+	g_pJob = NULL;
 
-	// Set Gap
-	switch ( pdm->dmMediaType )
-	{
-	case DMMEDIATYPE_GAPS:			// Label with Gaps
-		if ( pdm->dmMetric == DMMETRIC_INCH )
-			printer_printf("GAP %.3f,%.3f\r\n", POINT2INCH(pdm->dmGapHeight), POINT2INCH(pdm->dmGapOffset));
-		else
-			printer_printf("GAP %.1f mm,%.1f mm\r\n", POINT2MM(pdm->dmGapHeight), POINT2MM(pdm->dmGapOffset));
-		break;
-	case DMMEDIATYPE_MARK:			// Label with Mark
-		if ( pdm->dmMetric == DMMETRIC_INCH )
-			printer_printf("BLINE %.3f,%.3f\r\n", POINT2INCH(pdm->dmGapHeight), POINT2INCH(pdm->dmGapOffset));
-		else
-			printer_printf("BLINE %.1f mm,%.1f mm\r\n", POINT2MM(pdm->dmGapHeight), POINT2MM(pdm->dmGapOffset));
-		break;
-	case DMMEDIATYPE_CONTINUE:		// Continue
-		printer_printf("GAP 0,0\r\n");
-		break;
-	}
+	if ( pdm->dmAsyncIO == DMASYNCIO_ON && g_pUring == NULL
+		&& (g_pUring = UringOutCreate(fileno(stdout))) == NULL )
+		Error_Log(LEVEL_INFO, "No io_uring, output written as it is made\n");
 
-	// Set Speed
-	if ( pdm->dmFields & DM_PRINTSPEED )
-	{
-		if ( pdm->dmPrintSpeed % 10 )
-			printer_printf("SPEED %d.%d\r\n", pdm->dmPrintSpeed / 10, pdm->dmPrintSpeed % 10);
-		else
-			printer_printf("SPEED %d\r\n", pdm->dmPrintSpeed / 10);
-	}
-
-	// Set Density
-	if ( pdm->dmFields & DM_DARKNESS )
-		printer_printf("DENSITY %d\r\n", pdm->dmDarkness);
-
-// [0002] Li Add Start
-	// Set Ribbon
-	switch ( pdm->dmMediaMethod )
-	{
-	case DMMEDIAMETHOD_DIRECT:
-		printer_puts("SET RIBBON OFF\r\n");
-		break;
-	case DMMEDIAMETHOD_TRANSFER:
-		printer_puts("SET RIBBON ON\r\n");
-		break;
-	}
-// [0002] Li Add End
+	return TsplJobStart(TSPL_Job(pdm));
+}
 
-	// Set Direction
-	{
-		int		n = DIRECTION_LEFT_TOP;
-		int		m = DMMIRRORIMAGE_OFF;
-		
-		if ( pdm->dmFields & DM_MIRRORIMAGE )
-			m = pdm->dmMirrorImage;
+// The job goes into the stream of a label session, no preamble
+int TSPL_SendJobAppend(DEVMODE *pdm)
+{
+	return TsplJobAppend(TSPL_Job(pdm));
+}
 
-		printer_printf("DIRECTION %d,%d\r\n", n, m);
-	}
+int TSPL_SendJobEnd(DEVMODE *pdm)
+{
+	int		iRtn = TsplJobEnd(TSPL_Job(pdm));
+	double	dStart = GetSeconds();
 
-	// Set Reference
-	printer_printf("REFERENCE %.0f,%.0f\r\n",
-					POINT2DOT((double)pdm->dmAdjustHorizontal, pdm->dmPrintQuality),
-					POINT2DOT((double)pdm->dmAdjustVertical, pdm->dmYResolution));
+	if ( g_pUring && UringOutFlush(g_pUring) < 0 )
+		iRtn = -1;
+	g_dWriteTime += GetSeconds() - dStart;
 
-	// Set Offset
-	if ( pdm->dmMetric == DMMETRIC_INCH )
-		printer_printf("OFFSET %.3f\r\n", POINT2INCH(pdm->dmFeedOffset));
+	// The whole job went out, the printer has the setup of it now. The
+	// state file was unlinked at the job start, a failed job leaves it so.
+	if ( iRtn == 0 )
+		SetupStateSave();
 	else
-		printer_printf("OFFSET %.1f mm\r\n", POINT2MM(pdm->dmFeedOffset));
-
-	// Set Shift
-	printer_printf("SHIFT %.0f\r\n", POINT2DOT((double)pdm->dmVerticalOffset, pdm->dmYResolution));
-
-	// Set Action;
-#if 1
-	{
-		char	szON[] = "ON";
-		char	szOFF[] = "OFF";
-		char	szNumber[16] = "1";
-
-		const char	*szTear		= szOFF;
-		const char	*szPeel		= szOFF;
-		const char	*szCut		= szOFF;
-		const char	*szPartCut	= szOFF;
-
-		switch ( pdm->dmOccurrence )
-		{
-		case DMOCCURRENCE_EVERY:		// After Every Page
-			break;
-		case DMOCCURRENCE_COPIES:		// After Identical Copies
-			sprintf(szNumber, "%d", pdm->dmCopies);
-			break;
-		case DMOCCURRENCE_JOB:			// After Job
-			sprintf(szNumber, "%d", pdm->dmCopies * pdm->dmDocPages);
-			break;
-		case DMOCCURRENCE_SPECIFIED:	// After Specified interval
-			sprintf(szNumber, "%d", pdm->dmCutInterval);
-			break;
-		}
-
-		switch ( pdm->dmPostAction )
-		{
-		case DMPOSTACTION_NONE:			// None
-			break;
-		case DMPOSTACTION_TEAROFF:		// Tear Off
-			szTear = szON;
-			break;
-		case DMPOSTACTION_PEELOFF:		// Peel Off
-			szPeel = szON;
-			break;
-		case DMPOSTACTION_CUT:			// Cut
-			szCut = szNumber;
-			break;
-		case DMPOSTACTION_PARTIAL:		// Partial Cut
-			szPartCut = szNumber;
-			break;
-		}
-// [0002] Li Delete Start
-//		printer_printf(TSPL_SET_TEAR, szTear);
-//		printer_printf(TSPL_SET_PEEL, szPeel);
-//		printer_printf(TSPL_SET_CUTTER, szCut);
-//		printer_printf(TSPL_SET_PARTIAL_CUTTER, szPartCut);
-// [0002] Li Delete End
-// [0002] Li Add Start
-		{
-			const char	*szCmds[][2] = {
-				{TSPL_SET_TEAR, szTear},
-				{TSPL_SET_PEEL, szPeel},
-				{TSPL_SET_CUTTER, szCut},
-				{TSPL_SET_PARTIAL_CUTTER, szPartCut},
-			};
-			int			i;
-			for ( i=0; i<ARRAYCOUNT(szCmds); i++)
-			{
-				if ( szCmds[i][1] == szOFF )
-				{
-					printer_printf(szCmds[i][0], szCmds[i][1]);
-				}
-			}
-			for ( i=0; i<ARRAYCOUNT(szCmds); i++)
-			{
-				if ( szCmds[i][1] != szOFF )
-				{
-					printer_printf(szCmds[i][0], szCmds[i][1]);
-				}
-			}
-		}
-// [0002] Li Add End
-	}
-
-#else
-
-	switch ( pdm->dmPostAction )
-	{
-	case DMPOSTACTION_NONE:			// None
-		printer_puts("SET TEAR OFF\r\n");
-		printer_puts("SET PEEL OFF\r\n");
-		printer_puts("SET CUTTER OFF\r\n");
-		printer_puts("SET PARTIAL_CUTTER OFF\r\n");
-		break;
-	case DMPOSTACTION_TEAROFF:		// Tear Off
-		printer_puts("SET TEAR ON\r\n");
-		printer_puts("SET PEEL OFF\r\n");
-		printer_puts("SET CUTTER OFF\r\n");
-		printer_puts("SET PARTIAL_CUTTER OFF\r\n");
-		break;
-	case DMPOSTACTION_PEELOFF:		// Peel Off
-		printer_puts("SET TEAR OFF\r\n");
-		printer_puts("SET PEEL ON\r\n");
-		printer_puts("SET CUTTER OFF\r\n");
-		printer_puts("SET PARTIAL_CUTTER OFF\r\n");
-		break;
-	case DMPOSTACTION_CUT:			// Cut
-		switch ( pdm->dmOccurrence )
-		{
-		case DMOCCURRENCE_EVERY:		// After Every Page
-			printer_puts("SET TEAR OFF\r\n");
-			printer_puts("SET PEEL OFF\r\n");
-			printer_puts("SET CUTTER 1\r\n");
-			printer_puts("SET PARTIAL_CUTTER OFF\r\n");
-			break;
-		case DMOCCURRENCE_COPIES:		// After Identical Copies
-			printer_puts("SET TEAR OFF\r\n");
-			printer_puts("SET PEEL OFF\r\n");
-			printer_printf("SET CUTTER %d\r\n", pdm->dmCopies);
-			printer_puts("SET PARTIAL_CUTTER OFF\r\n");
-			break;
-		case DMOCCURRENCE_JOB:			// After Job
-			printer_puts("SET TEAR OFF\r\n");
-			printer_puts("SET PEEL OFF\r\n");
-			printer_printf("SET CUTTER %d\r\n", pdm->dmCopies * pdm->dmDocPages);
-			printer_puts("SET PARTIAL_CUTTER OFF\r\n");
-			break;
-		case DMOCCURRENCE_SPECIFIED:	// After Specified interval
-			printer_puts("SET TEAR OFF\r\n");
-			printer_puts("SET PEEL OFF\r\n");
-			printer_printf("SET CUTTER %d\r\n", pdm->dmCutInterval);
-			printer_puts("SET PARTIAL_CUTTER OFF\r\n");
-			break;
-		}
-		break;
-	case DMPOSTACTION_PARTIAL:		// Partial Cut
-		switch ( pdm->dmOccurrence )
-		{
-		case DMOCCURRENCE_EVERY:		// After Every Page
-			printer_puts("SET TEAR OFF\r\n");
-			printer_puts("SET PEEL OFF\r\n");
-			printer_puts("SET CUTTER OFF\r\n");
-			printer_puts("SET PARTIAL_CUTTER 1\r\n");
-			break;
-		case DMOCCURRENCE_COPIES:		// After Identical Copies
-			printer_puts("SET TEAR OFF\r\n");
-			printer_puts("SET PEEL OFF\r\n");
-			printer_puts("SET CUTTER OFF\r\n");
-			printer_printf("SET PARTIAL_CUTTER %d\r\n", pdm->dmCopies);
-			break;
-		case DMOCCURRENCE_JOB:			// After Job
-			printer_puts("SET TEAR OFF\r\n");
-			printer_puts("SET PEEL OFF\r\n");
-			printer_puts("SET CUTTER OFF\r\n");
-			printer_printf("SET PARTIAL_CUTTER %d\r\n", pdm->dmCopies * pdm->dmDocPages);
-			break;
-		case DMOCCURRENCE_SPECIFIED:	// After Specified interval
-			printer_puts("SET TEAR OFF\r\n");
-			printer_puts("SET PEEL OFF\r\n");
-			printer_puts("SET CUTTER OFF\r\n");
-			printer_printf("SET PARTIAL_CUTTER %d\r\n", pdm->dmCutInterval);
-			break;
-		}
-		break;
-	}
-#endif
-
-// [0002] Li Delete Start
-//	// Set Ribbon
-//	switch ( pdm->dmMediaMethod )
-//	{
-//	case DMMEDIAMETHOD_DIRECT:
-//		printer_puts("SET RIBBON OFF\r\n");
-//		break;
-//	case DMMEDIAMETHOD_TRANSFER:
-//		printer_puts("SET RIBBON ON\r\n");
-//		break;
-//	}
-// [0002] Li Delete End
+		g_setup.bEnable = FALSE;
+	return iRtn;
 }
 
-int TSPL_SendJobEnd(DEVMODE *pdm)
+int TSPL_SendCutInterval(DEVMODE *pdm, unsigned nLabels)
 {
-	// Set User Command - End Job
-	TSPL_SendUserCommand(pdm, DM_CMDENDJOB);
+	return TsplJobCutInterval(TSPL_Job(pdm), nLabels);
 }
 
 int TSPL_SendPageStart(DEVMODE *pdm)
 {
-	// Cls
-	printer_puts("CLS\r\n");
-
-	// Set User Command - Start Label
-	TSPL_SendUserCommand(pdm, DM_CMDSTARTLABEL);
+	return TsplPageStart(TSPL_Job(pdm));
 }
 
 int TSPL_SendPageEnd(DEVMODE *pdm)
 {
-	// REVERSE
-	if( (pdm->dmFields & DM_NEGATIVEIMAGE) && (pdm->dmNegativeImage != DMNEGATIVEIMAGE_OFF))
-	{
-		printer_printf("REVERSE 0,0,%.0f,%.0f\r\n",
-						POINT2DOT(pdm->dmPaperWidth, pdm->dmPrintQuality),
-						POINT2DOT(pdm->dmPaperLength, pdm->dmYResolution));
-	}
-
-	// PRINT
-	printer_printf("PRINT %d,%d\r\n", 1, pdm->dmCollate ? 1 : pdm->dmCopies);
-	
-	// Set User Command - End Label
-	TSPL_SendUserCommand(pdm, DM_CMDENDLABEL);
+	return TsplPageEnd(TSPL_Job(pdm));
 }
 
-int TSPL_SendPage(DEVMODE *pdm, BITMAPINFOHEADER* pBih, RGBQUAD *pColorTable, void* pBits)
+int TSPL_SendPage(DEVMODE *pdm, int x, int y, BITMAPINFOHEADER* pBih, RGBQUAD *pColorTable, void* pBits)
 {
 	DebugPrintf("Enter TSPL_SendPage\n");
 
@@ -348,7 +132,9 @@ int TSPL_SendPage(DEVMODE *pdm, BITMAPINFOHEADER* pBih, RGBQUAD *pColorTable, vo
 	switch( pBih->biBitCount )
 	{
 	case 1:
-		TSPL_SendBitmap1bpp(pdm, pBih, pBits);
+		// Bottom-up rows are printed as they come, as always
+		TsplPageBitmap(TSPL_Job(pdm), x, y, pBih->biWidth, pBih->biHeight,
+						pBits, WIDTHBYTES_32(pBih->biWidth), TSPLBITMAP_BLACK1);
 		break;
 	case 8:
 		break;
@@ -359,114 +145,181 @@ int TSPL_SendPage(DEVMODE *pdm, BITMAPINFOHEADER* pBih, RGBQUAD *pColorTable, vo
 	return 1;
 }
 
-int TSPL_SendBitmap1bpp(DEVMODE *pdm, BITMAPINFOHEADER* pBih, void* pBits)
+// Rows in printer order in a file, sent without a copy through user space
+int TSPL_SendBitmapFile(DEVMODE *pdm, int nWidth, int nHeight, int fd, off_t offset)
 {
-	int		ix = 0;									// x-coordinate
-	int		iy = 0;									// y-coordinate
-	int		iWidth = WIDTHBYTES_8(pBih->biWidth);	// The width of the image in bytes
-	int		iHeight = pBih->biHeight;				// The height of the image in dot
-	int		x, y;
-	DWORD	cbWidthBytes = WIDTHBYTES_32(pBih->biWidth);
-	BYTE*	pBitsLine;
-
-	pBitsLine = MEMALLOC(iWidth);
-	if ( pBitsLine )
-	{
-		printer_printf("BITMAP %d,%d,%d,%d,%d,", ix, iy, iWidth, iHeight, DRAWMODE_OR);
-	
-		for(y=0; y<pBih->biHeight; y++)
-		{
-			memcpy(pBitsLine, pBits + cbWidthBytes * y, iWidth);
-			for (x=0; x<iWidth; x++)
-				pBitsLine[x] = ~pBitsLine[x];
-			printer_write(pBitsLine, iWidth);
-		}
-		printer_printf("\r\n");
-		MEMFREE(pBitsLine);
-	}
-	return 1;
+	return TsplPageBitmapFile(TSPL_Job(pdm), 0, 0, nWidth, nHeight, fd, offset);
 }
 
-int TSPL_SendUserCommand(DEVMODE *pdm, DWORD dwField)
+int TSPL_SendBarcode(DEVMODE *pdm, int x, int y, const char *pszType, int nHeight, int nNarrow, const char *pszData)
 {
-	WORD	wLength = 0;
-	LPBYTE	pCmdDat = NULL;
+	return TsplPageBarcode(TSPL_Job(pdm), x, y, pszType, nHeight, nNarrow, nNarrow, pszData);
+}
 
-	if ( pdm->dmFields & dwField )
-	{
-		switch (dwField)
-		{
-		case DM_CMDSTARTJOB:
-			pCmdDat = pdm->dmCmdStartJob;
-			wLength = pdm->dmCmdStartJobLength;
-			break;
-		case DM_CMDSTARTLABEL:
-			pCmdDat = pdm->dmCmdStartLable;
-			wLength = pdm->dmCmdStartLabelLength;
-			break;
-		case DM_CMDENDLABEL:
-			pCmdDat = pdm->dmCmdEndLable;
-			wLength = pdm->dmCmdEndLabelLength;
-			break;
-		case DM_CMDENDJOB:
-			pCmdDat = pdm->dmCmdEndJob;
-			wLength = pdm->dmCmdEndJobLength;
-			break;
-		}
-	}	
+// Output not made here went to the printer, what it is set up for is unknown
+int TSPL_SetupStateReset(DEVMODE *pdm)
+{
+	SetupStateLoad(pdm);
+	g_setup.bEnable = FALSE;
+	return 0;
+}
 
-	if ( pCmdDat && wLength > 0 )
-	{
-		printer_write(pCmdDat, wLength);
-	}
+// The job failed, what the printer is set up for is unknown
+int TSPL_SetupStateDiscard(DEVMODE *pdm)
+{
+	g_setup.bEnable = FALSE;
+	if ( g_setup.szFile[0] )
+		unlink(g_setup.szFile);
+	return 0;
+}
+
+TSPLJOB* TSPL_Job(DEVMODE *pdm)
+{
+	TSPLSINK	sink;
+
+	if ( g_pJob && TsplJobDevmode(g_pJob) == pdm )
+		return g_pJob;
+
+	TsplJobDestroy(g_pJob);
+
+	sink.pfnWrite = StdoutWrite;
+	sink.pfnSendFile = StdoutSendFile;
+	sink.pContext = NULL;
+	g_pJob = TsplJobCreate(pdm, &sink, g_setup.bEnable ? &g_setup.setup : NULL);
+	return g_pJob;
 }
 
-size_t printer_write(const void* pbuf, size_t cbbuf)
+// Bytes for the printer that are not part of the job, as a status request.
+// What is queued behind goes out first, so they fall between commands.
+ssize_t TSPL_WriteControl(const void *pbuf, size_t cbbuf)
 {
-//	DebugPrintf("printer_write %d bytes\n", cbbuf);
-	return write(fileno(stdout), pbuf, cbbuf);
+	if ( g_pUring && UringOutFlush(g_pUring) < 0 )
+		return -1;
+	return NetWriteAll(fileno(stdout), pbuf, cbbuf);
 }
 
-int printer_printf(const char* strfmt, ...)
+// Output written and the time it took so far, for the print time report
+void TSPL_WriteStats(double *pdSeconds, double *pdBytes)
 {
-	int		iRtn = -1;
-	int		size = 128;
-	va_list	args;
+	*pdSeconds = g_dWriteTime;
+	*pdBytes = g_dWriteBytes;
+}
+
+ssize_t StdoutWrite(void *pContext, const void *pbuf, size_t cbbuf)
+{
+	double	dStart;
+	ssize_t	nBytes;
+
+	JobCacheWrite(pbuf, cbbuf);
+
+	dStart = GetSeconds();
+	if ( g_pUring )
+		nBytes = UringOutWrite(g_pUring, pbuf, cbbuf);
+	else
+		nBytes = NetWriteAll(fileno(stdout), pbuf, cbbuf);
+	dStart = GetSeconds() - dStart;
+	g_dWriteTime += dStart;
+	g_dWriteBytes += cbbuf;
+	TSC_PROBE3(output__write, cbbuf, nBytes, (long)(dStart * 1000000));
+	return nBytes;
+}
+
+ssize_t StdoutSendFile(void *pContext, int fd, off_t offset, size_t count)
+{
+	double	dStart;
+	ssize_t	nBytes;
+
+	JobCacheWriteFile(fd, offset, count);
+
+	dStart = GetSeconds();
+	if ( g_pUring )
+		nBytes = UringOutSendFile(g_pUring, fd, offset, count);
+	else
+		nBytes = NetSendFile(fileno(stdout), fd, offset, count);
+	dStart = GetSeconds() - dStart;
+	g_dWriteTime += dStart;
+	g_dWriteBytes += count;
+	TSC_PROBE3(output__write, count, nBytes, (long)(dStart * 1000000));
+	return nBytes;
+}
+
+void SetupStateLoad(DEVMODE *pdm)
+{
+	FILE	*fp;
+	char	szLine[TSPLSETUP_COMMAND_LENGTH];
+	char	*szPrinter;
+	char	*szDir;
 	char	*p;
+	long	tSaved;
+	int		i;
+
+	memset(&g_setup, 0, sizeof(g_setup));
 
-	// Guess we need no more than 128 bytes.
-	while ((p = MEMALLOC(size)) != NULL)
+	if ( pdm->dmSetupCache != DMSETUPCACHE_ON || (szPrinter = getenv("PRINTER")) == NULL || *szPrinter == 0 )
+		return;
+	if ( (szDir = getenv("CUPS_CACHEDIR")) == NULL )
+		szDir = SETUP_STATE_DIR;
+
+	snprintf(g_setup.szFile, sizeof(g_setup.szFile), SETUP_STATE_FILE, szDir, szPrinter);
+	for (p = g_setup.szFile + strlen(szDir) + 1; *p; p++)
 	{
-		// Try to print in the allocated space.
-		va_start(args, strfmt);
-		iRtn = vsnprintf(p, size, strfmt, args);
-		va_end(args);
+		if ( *p == '/' )
+			*p = '_';
+	}
+	g_setup.bEnable = TRUE;
 
-		// If that worked, break;
-		if (iRtn > -1 && iRtn < size)
+	if ( pdm->dmSetupReset )
+	{
+		DebugPrintf("Setup state reset\n");
+	}
+	else if ( (fp = fopen(g_setup.szFile, "r")) != NULL )
+	{
+		if ( fgets(szLine, sizeof(szLine), fp)
+			&& sscanf(szLine, SETUP_STATE_MARKER " %ld", &tSaved) == 1
+			&& time(NULL) >= tSaved
+			&& time(NULL) - tSaved <= (pdm->dmSetupTimeout ? pdm->dmSetupTimeout : SETUPTIMEOUT_DEF_VALUE) )
 		{
-			break;
+			for (i=0; i<TSPLSETUP_COUNT && fgets(szLine, sizeof(szLine) - 2, fp); i++)
+			{
+				if ( (p = strchr(szLine, '\n')) != NULL )
+					*p = 0;
+				if ( *szLine )
+					sprintf(g_setup.setup.szCmds[i], "%s\r\n", szLine);
+			}
+			g_setup.setup.bLoaded = ( i == TSPLSETUP_COUNT );
 		}
-		
-		// Else try again with more space. */
-		if (iRtn > -1)		// glibc 2.1
-			size = iRtn+1;	// precisely what is needed
-		else				// glibc 2.0
-			size *= 2;		// twice the old size
-
-		MEMFREE(p);
+		fclose(fp);
 	}
 
-	if ( p )
-	{
-		iRtn = printer_write(p, iRtn);
-		MEMFREE(p);
-	}
+	if ( !g_setup.setup.bLoaded )
+		memset(g_setup.setup.szCmds, 0, sizeof(g_setup.setup.szCmds));
 
-	return iRtn;
+	// Until the job ends the printer setup is unknown
+	unlink(g_setup.szFile);
 }
 
-size_t printer_puts(const char* str)
+void SetupStateSave(void)
 {
-	return printer_write(str, strlen(str));
+	FILE	*fp;
+	char	szTemp[sizeof(g_setup.szFile) + 8];
+	int		i;
+
+	if ( !g_setup.bEnable )
+		return;
+
+	snprintf(szTemp, sizeof(szTemp), "%s.%d", g_setup.szFile, (int)getpid());
+	if ( (fp = fopen(szTemp, "w")) == NULL )
+	{
+		DebugPrintf("Unable to save setup state %s - %s\n", szTemp, strerror(errno));
+		return;
+	}
+
+	fprintf(fp, SETUP_STATE_MARKER " %ld\n", (long)time(NULL));
+	for (i=0; i<TSPLSETUP_COUNT; i++)
+		fprintf(fp, "%.*s\n", (int)strcspn(g_setup.setup.szCmds[i], "\r\n"), g_setup.setup.szCmds[i]);
+
+	if ( fclose(fp) || rename(szTemp, g_setup.szFile) )
+		unlink(szTemp);
+
+	g_setup.bEnable = FALSE;
 }
@@ -0,0 +1,382 @@
+/*
+ * "tsplsessiond.c 2026-10-17 10:12:40
+ *
+ *  resident label session service for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include "config.h"
+#include "common.h"
+#include "debug.h"
+#include "device.h"
+#include "netio.h"
+#include "session.h"
+
+#include <grp.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+
+typedef struct _SESSION
+{
+	const char		*szDeviceURI;		// Printer device URI
+	BOOL			bOpen;				// Printer connection is on stdout
+	DEVMODE			dm;					// Setup of the open TSPL stream
+	int				nJobs;				// Jobs coalesced into the stream
+} SESSION;
+
+int TSPL_SendJobStart(DEVMODE *pdm);
+int TSPL_SendJobEnd(DEVMODE *pdm);
+int TSPL_SetupStateReset(DEVMODE *pdm);
+
+static BOOL SessionOpen(SESSION *psess, DEVMODE *pdm);
+static void SessionClose(SESSION *psess, BOOL bEndJob);
+static DWORD SessionJob(SESSION *psess, int fdClient);
+static BOOL SessionAlive(void);
+static BOOL SessionCopy(FILE *fpSpool, off_t length);
+static BOOL IsSameJobSetup(DEVMODE *pdm1, DEVMODE *pdm2);
+static size_t ReadSocket(int fd, void *buffer, size_t size);
+
+/*
+	argv[1] = Printer name
+	argv[2] = Device URI, socket://host[:port]
+	argv[3] = Coalesce window in ms (optional)
+*/
+int main(int argc, char *argv[])
+{
+	int				fdListen;
+	int				nWindow = SESSION_DEFAULT_WINDOW;
+	char			szSocket[256];
+	SESSION			sess;
+	struct group	*pgr;
+
+	setbuf(stderr, NULL);
+
+	if ( argc < 3 || argc > 4 )
+	{
+		fprintf(stderr, "Usage: %s printer device-uri [window-ms]\n", argv[0]);
+		return 1;
+	}
+	if ( argc == 4 && atoi(argv[3]) > 0 )
+		nWindow = atoi(argv[3]);
+
+	signal(SIGPIPE, SIG_IGN);
+
+	// Queue name of the setup state cache, as set by cupsd for filters
+	setenv("PRINTER", argv[1], 1);
+
+	mkdir(TSC_SESSION_DIR, 0755);
+	snprintf(szSocket, sizeof(szSocket), TSC_SESSION_SOCKET, argv[1]);
+	if ( (fdListen = NetListenUnixSocket(szSocket)) < 0 )
+		return 1;
+
+	// Only root and the CUPS filters may queue jobs
+	if ( (pgr = getgrnam(SESSION_GROUP)) == NULL || chown(szSocket, -1, pgr->gr_gid) )
+		Error_Log(LEVEL_WARNING, "Unable to give %s to group %s\n", szSocket, SESSION_GROUP);
+	chmod(szSocket, 0660);
+
+	memset(&sess, 0, sizeof(sess));
+	sess.szDeviceURI = argv[2];
+
+	Error_Log(LEVEL_INFO, "tsplsessiond: %s -> %s, window %d ms\n", szSocket, argv[2], nWindow);
+
+	while (1)
+	{
+		struct pollfd	pfd;
+		struct timeval	tv;
+		SESSIONREPLY	reply;
+		int				fdClient;
+		int				n;
+
+		pfd.fd = fdListen;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+
+		n = poll(&pfd, 1, sess.bOpen ? nWindow : -1);
+		if ( n < 0 )
+		{
+			if ( errno == EINTR )
+				continue;
+			Error_Log(LEVEL_ERROR, "poll: %s\n", strerror(errno));
+			break;
+		}
+		if ( n == 0 )
+		{
+			// Window expired, finish the TSPL stream
+			SessionClose(&sess, TRUE);
+			continue;
+		}
+
+		if ( (fdClient = accept(fdListen, NULL, NULL)) < 0 )
+			continue;
+
+		// Jobs are taken one at a time, a client that stalls must not hold up the queue
+		tv.tv_sec = SESSION_READ_TIMEOUT;
+		tv.tv_usec = 0;
+		setsockopt(fdClient, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+		reply.srMarker = SESSION_REPLY_MARKER;
+		reply.srStatus = SessionJob(&sess, fdClient);
+		NetWriteAll(fdClient, &reply, sizeof(reply));
+		close(fdClient);
+	}
+
+	SessionClose(&sess, TRUE);
+	close(fdListen);
+	unlink(szSocket);
+	return 0;
+}
+
+// SESSION_STATUS_* of the job, for the reply to the filter
+DWORD SessionJob(SESSION *psess, int fdClient)
+{
+	SESSIONHEADER	header;
+	SESSIONTRAILER	trailer;
+	FILE			*fpSpool;
+	char			buffer[65536];
+	size_t			nBytes;
+	off_t			length;
+
+	if ( ReadSocket(fdClient, &header, sizeof(header)) != sizeof(header)
+		|| header.shMarker != SESSION_HEADER_MARKER
+		|| header.shSize != sizeof(SESSIONHEADER)
+		|| header.shDevmode.dmType != DM_HEADER_MARKER
+		|| header.shDevmode.dmSize != sizeof(DEVMODE)
+		|| header.shDevmode.dmCmdStartJobLength > DM_USER_COMMOND_LENGTH
+		|| header.shDevmode.dmCmdStartLabelLength > DM_USER_COMMOND_LENGTH
+		|| header.shDevmode.dmCmdEndLabelLength > DM_USER_COMMOND_LENGTH
+		|| header.shDevmode.dmCmdEndJobLength > DM_USER_COMMOND_LENGTH )
+	{
+		Error_Log(LEVEL_WARNING, "Invalid session header, job discarded\n");
+		return SESSION_STATUS_INVALID;
+	}
+
+	// Spool the whole job first, a filter that dies half way must not
+	// leave a partial command in the printer stream.
+	if ( (fpSpool = tmpfile()) == NULL )
+	{
+		Error_Log(LEVEL_ERROR, "Unable to create spool file: %s\n", strerror(errno));
+		return SESSION_STATUS_FAILED;
+	}
+	while ( (nBytes = ReadSocket(fdClient, buffer, sizeof(buffer))) > 0 )
+	{
+		if ( fwrite(buffer, 1, nBytes, fpSpool) != nBytes )
+		{
+			Error_Log(LEVEL_ERROR, "IO error: %s\n", strerror(errno));
+			fclose(fpSpool);
+			return SESSION_STATUS_FAILED;
+		}
+	}
+
+	length = ftello(fpSpool) - sizeof(trailer);
+	if ( length < 0
+		|| fseeko(fpSpool, length, SEEK_SET)
+		|| fread(&trailer, 1, sizeof(trailer), fpSpool) != sizeof(trailer)
+		|| trailer.stMarker != SESSION_TRAILER_MARKER )
+	{
+		Error_Log(LEVEL_WARNING, "Incomplete session job, discarded\n");
+		fclose(fpSpool);
+		return SESSION_STATUS_INVALID;
+	}
+
+	if ( psess->bOpen && !IsSameJobSetup(&psess->dm, &header.shDevmode) )
+	{
+		DebugPrintf("Job setup changed, new TSPL stream\n");
+		SessionClose(psess, TRUE);
+	}
+
+	// Nothing of this job is sent yet, a printer that dropped the open
+	// stream is simply connected again
+	if ( psess->bOpen && !SessionAlive() )
+	{
+		Error_Log(LEVEL_INFO, "Printer closed the session, reconnect\n");
+		SessionClose(psess, FALSE);
+	}
+
+	if ( !psess->bOpen && !SessionOpen(psess, &header.shDevmode) )
+	{
+		Error_Log(LEVEL_ERROR, "Unable to connect to printer %s\n", psess->szDeviceURI);
+		fclose(fpSpool);
+		return SESSION_STATUS_FAILED;
+	}
+
+	// Part of the job may be printed already, it is not sent again
+	if ( !SessionCopy(fpSpool, length) )
+	{
+		Error_Log(LEVEL_ERROR, "Printer write error: %s, job not completed\n", strerror(errno));
+		SessionClose(psess, FALSE);
+		fclose(fpSpool);
+		return SESSION_STATUS_FAILED;
+	}
+
+	psess->nJobs ++;
+	DebugPrintf("Job %d of session, %ld bytes\n", psess->nJobs, (long)length);
+	fclose(fpSpool);
+	return SESSION_STATUS_OK;
+}
+
+BOOL SessionOpen(SESSION *psess, DEVMODE *pdm)
+{
+	int		fd;
+
+	if ( (fd = NetOpenDeviceURI(psess->szDeviceURI)) < 0 )
+		return FALSE;
+
+	// TSPL routines write to stdout
+	if ( dup2(fd, STDOUT_FILENO) < 0 )
+	{
+		close(fd);
+		return FALSE;
+	}
+	close(fd);
+	NetTuneStream(STDOUT_FILENO);
+
+	memcpy(&psess->dm, pdm, sizeof(DEVMODE));
+	psess->bOpen = TRUE;
+	psess->nJobs = 0;
+
+	if ( TSPL_SendJobStart(&psess->dm) < 0 )
+	{
+		SessionClose(psess, FALSE);
+		return FALSE;
+	}
+
+	// The jobs send SIZE, GAP and SPEED of their pages, the setup the
+	// printer is left with is not known here
+	TSPL_SetupStateReset(&psess->dm);
+	return TRUE;
+}
+
+void SessionClose(SESSION *psess, BOOL bEndJob)
+{
+	int		fd;
+
+	if ( !psess->bOpen )
+		return;
+
+	if ( bEndJob )
+		TSPL_SendJobEnd(&psess->dm);
+
+	Error_Log(LEVEL_INFO, "Session closed, %d jobs in one TSPL stream\n", psess->nJobs);
+
+	if ( (fd = open("/dev/null", O_WRONLY)) >= 0 )
+	{
+		dup2(fd, STDOUT_FILENO);
+		close(fd);
+	}
+	psess->bOpen = FALSE;
+}
+
+// The printer ends the connection by an EOF or error on the open stream
+BOOL SessionAlive(void)
+{
+	struct pollfd	pfd;
+	char			c;
+
+	pfd.fd = STDOUT_FILENO;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+
+	if ( poll(&pfd, 1, 0) <= 0 )
+		return TRUE;
+	if ( pfd.revents & (POLLERR | POLLHUP) )
+		return FALSE;
+
+	// Status the printer sent back is no matter here, only the EOF
+	return recv(STDOUT_FILENO, &c, 1, MSG_PEEK | MSG_DONTWAIT) != 0;
+}
+
+BOOL SessionCopy(FILE *fpSpool, off_t length)
+{
+	ssize_t		nBytes;
+
+	if ( fflush(fpSpool) )
+		return FALSE;
+
+	NetCork(STDOUT_FILENO, TRUE);
+	nBytes = NetSendFile(STDOUT_FILENO, fileno(fpSpool), 0, length);
+	NetCork(STDOUT_FILENO, FALSE);
+
+	return nBytes == length;
+}
+
+// Every setting that TSPL_SendJobStart() puts into the job preamble
+BOOL IsSameJobSetup(DEVMODE *pdm1, DEVMODE *pdm2)
+{
+	if ( pdm1->dmPaperWidth != pdm2->dmPaperWidth
+		|| pdm1->dmPaperLength != pdm2->dmPaperLength
+		|| pdm1->dmMediaType != pdm2->dmMediaType
+		|| pdm1->dmGapHeight != pdm2->dmGapHeight
+		|| pdm1->dmGapOffset != pdm2->dmGapOffset
+		|| (pdm1->dmFields & (DM_PRINTSPEED | DM_DARKNESS | DM_MIRRORIMAGE | DM_ORIENTATION))
+			!= (pdm2->dmFields & (DM_PRINTSPEED | DM_DARKNESS | DM_MIRRORIMAGE | DM_ORIENTATION))
+		|| pdm1->dmOrientation != pdm2->dmOrientation
+		|| pdm1->dmPrintSpeed != pdm2->dmPrintSpeed
+		|| pdm1->dmDarkness != pdm2->dmDarkness
+		|| pdm1->dmMediaMethod != pdm2->dmMediaMethod
+		|| pdm1->dmMirrorImage != pdm2->dmMirrorImage
+		|| pdm1->dmAdjustHorizontal != pdm2->dmAdjustHorizontal
+		|| pdm1->dmAdjustVertical != pdm2->dmAdjustVertical
+		|| pdm1->dmFeedOffset != pdm2->dmFeedOffset
+		|| pdm1->dmVerticalOffset != pdm2->dmVerticalOffset
+		|| pdm1->dmPostAction != pdm2->dmPostAction
+		|| pdm1->dmOccurrence != pdm2->dmOccurrence
+		|| pdm1->dmCutInterval != pdm2->dmCutInterval
+		|| pdm1->dmMetric != pdm2->dmMetric
+		|| pdm1->dmPrintQuality != pdm2->dmPrintQuality
+		|| pdm1->dmYResolution != pdm2->dmYResolution )
+		return FALSE;
+
+	// The speed of each label is not undone by the next job
+	if ( pdm1->dmAdaptiveSpeed == DMADAPTIVESPEED_ON || pdm2->dmAdaptiveSpeed == DMADAPTIVESPEED_ON )
+		return FALSE;
+
+	// Cutter counts of the preamble depend on the copies
+	if ( pdm1->dmOccurrence == DMOCCURRENCE_COPIES && pdm1->dmCopies != pdm2->dmCopies )
+		return FALSE;
+	if ( pdm1->dmOccurrence == DMOCCURRENCE_JOB )
+		return FALSE;
+
+	// User commands of start and end job
+	if ( (pdm1->dmFields & (DM_CMDSTARTJOB | DM_CMDENDJOB)) != (pdm2->dmFields & (DM_CMDSTARTJOB | DM_CMDENDJOB))
+		|| pdm1->dmCmdStartJobLength != pdm2->dmCmdStartJobLength
+		|| pdm1->dmCmdEndJobLength != pdm2->dmCmdEndJobLength
+		|| memcmp(pdm1->dmCmdStartJob, pdm2->dmCmdStartJob, min(pdm1->dmCmdStartJobLength, DM_USER_COMMOND_LENGTH))
+		|| memcmp(pdm1->dmCmdEndJob, pdm2->dmCmdEndJob, min(pdm1->dmCmdEndJobLength, DM_USER_COMMOND_LENGTH)) )
+		return FALSE;
+
+	return TRUE;
+}
+
+size_t ReadSocket(int fd, void* buffer, size_t size)
+{
+	ssize_t	nBytes;
+	size_t	nReaded = 0;
+
+	while ( nReaded < size )
+	{
+		nBytes = read(fd, (BYTE*)buffer + nReaded, size - nReaded);
+		if ( nBytes < 0 && errno == EINTR )
+			continue;
+		if ( nBytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) )
+			Error_Log(LEVEL_WARNING, "Session client stalled for %d seconds\n", SESSION_READ_TIMEOUT);
+		if ( nBytes <= 0 )
+			break;
+		nReaded += nBytes;
+	}
+
+	return nReaded;
+}
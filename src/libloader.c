@@ -85,6 +85,7 @@ int	LoadCupsLibrary(CUPSLIB_FUNCTION* cupsfun)
 		cupsfun->cupsFreeOptions = (PFN_cupsFreeOptions) dlsym(cupsfun->hmodule, "cupsFreeOptions");
 		cupsfun->cupsGetPPD = (PFN_cupsGetPPD) dlsym(cupsfun->hmodule, "cupsGetPPD");
 		cupsfun->cupsTempFile2 = (PFN_cupsTempFile2) dlsym(cupsfun->hmodule, "cupsTempFile2");
+		cupsfun->cupsBackChannelRead = (PFN_cupsBackChannelRead) dlsym(cupsfun->hmodule, "cupsBackChannelRead");
 
 		cupsfun->ppdOpenFile = (PFN_ppdOpenFile) dlsym(cupsfun->hmodule, "ppdOpenFile");
 		cupsfun->ppdClose = (PFN_ppdClose) dlsym(cupsfun->hmodule, "ppdClose");
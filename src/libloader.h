@@ -59,6 +59,7 @@ typedef int	(GSDLLAPIPTR PFN_cupsMarkOptions)(ppd_file_t *ppd, int num_options,
 			                cups_option_t *options);
 typedef const char	*(GSDLLAPIPTR PFN_cupsGetPPD)(const char *printer);
 typedef cups_file_t	*(GSDLLAPIPTR PFN_cupsTempFile2)(char *filename, int len);
+typedef ssize_t		(GSDLLAPIPTR PFN_cupsBackChannelRead)(char *buffer, size_t bytes, double timeout);
 	
 
 /************ ppd.h (version 1.2) ************/
@@ -118,6 +119,7 @@ typedef struct _CUPSLIB_FUNCTION {
 	PFN_cupsFreeOptions			cupsFreeOptions;
 	PFN_cupsGetPPD				cupsGetPPD;
 	PFN_cupsTempFile2			cupsTempFile2;
+	PFN_cupsBackChannelRead		cupsBackChannelRead;		// NULL before CUPS 1.2
 
 	// ppd.h
 	PFN_ppdOpenFile				ppdOpenFile;
@@ -0,0 +1,234 @@
+/*
+ * "netio.c 2026-10-17 10:12:40
+ *
+ *  network output routine for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include "config.h"
+#include "common.h"
+#include "debug.h"
+#include "netio.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+
+// Connect to "scheme://host[:port][/...]", the port defaults to 9100.
+int NetOpenDeviceURI(const char *szURI)
+{
+	int					fd = -1;
+	char				szHost[256];
+	char				szPort[16];
+	const char			*pHost;
+	const char			*pEnd;
+	struct addrinfo		hints;
+	struct addrinfo		*addrs = NULL;
+	struct addrinfo		*ai;
+
+	if ( szURI == NULL )
+		return -1;
+
+	pHost = strstr(szURI, "://");
+	pHost = pHost ? pHost + 3 : szURI;
+
+	for (pEnd = pHost; *pEnd && *pEnd != ':' && *pEnd != '/' && *pEnd != '?'; pEnd++)
+		;
+	if ( pEnd == pHost || pEnd - pHost >= sizeof(szHost) )
+	{
+		Error_Log(LEVEL_ERROR, "Bad device URI \"%s\"\n", szURI);
+		return -1;
+	}
+	memcpy(szHost, pHost, pEnd - pHost);
+	szHost[pEnd - pHost] = 0;
+
+	if ( *pEnd == ':' )
+		snprintf(szPort, sizeof(szPort), "%d", atoi(pEnd + 1));
+	else
+		snprintf(szPort, sizeof(szPort), "%d", NETIO_DEFAULT_PORT);
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family   = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	if ( getaddrinfo(szHost, szPort, &hints, &addrs) )
+	{
+		Error_Log(LEVEL_ERROR, "Unable to look up printer address \"%s\"\n", szHost);
+		return -1;
+	}
+
+	for (ai = addrs; ai; ai = ai->ai_next)
+	{
+		fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+		if ( fd < 0 )
+			continue;
+		if ( connect(fd, ai->ai_addr, ai->ai_addrlen) == 0 )
+			break;
+		close(fd);
+		fd = -1;
+	}
+	freeaddrinfo(addrs);
+
+	if ( fd < 0 )
+		Error_Log(LEVEL_ERROR, "Unable to connect to printer %s:%s - %s\n", szHost, szPort, strerror(errno));
+	else
+		DebugPrintf("NetOpenDeviceURI: connected to %s:%s\n", szHost, szPort);
+
+	return fd;
+}
+
+static int NetUnixAddress(const char *szPath, struct sockaddr_un *addr)
+{
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	if ( szPath == NULL || strlen(szPath) >= sizeof(addr->sun_path) )
+		return -1;
+	strcpy(addr->sun_path, szPath);
+	return 0;
+}
+
+int NetOpenUnixSocket(const char *szPath)
+{
+	int					fd;
+	struct sockaddr_un	addr;
+
+	if ( NetUnixAddress(szPath, &addr) )
+		return -1;
+
+	if ( (fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0 )
+		return -1;
+
+	if ( connect(fd, (struct sockaddr *)&addr, sizeof(addr)) )
+	{
+		DebugPrintf("NetOpenUnixSocket: %s - %s\n", szPath, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+int NetListenUnixSocket(const char *szPath)
+{
+	int					fd;
+	struct sockaddr_un	addr;
+
+	if ( NetUnixAddress(szPath, &addr) )
+		return -1;
+
+	if ( (fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0 )
+		return -1;
+
+	// Remove a stale socket left by a previous instance
+	unlink(szPath);
+	if ( bind(fd, (struct sockaddr *)&addr, sizeof(addr)) || listen(fd, 16) )
+	{
+		Error_Log(LEVEL_ERROR, "Unable to listen on %s - %s\n", szPath, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+// A non-blocking descriptor that is full: sleep until it drains instead of spinning.
+static int NetWaitWritable(int fd)
+{
+	struct pollfd	pfd;
+
+	pfd.fd = fd;
+	pfd.events = POLLOUT;
+	pfd.revents = 0;
+	if ( poll(&pfd, 1, -1) < 0 && errno != EINTR )
+		return -1;
+	return 0;
+}
+
+ssize_t NetWriteAll(int fd, const void *pbuf, size_t cbbuf)
+{
+	size_t		nWritten = 0;
+	ssize_t		nBytes;
+
+	while ( nWritten < cbbuf )
+	{
+		nBytes = write(fd, (const BYTE*)pbuf + nWritten, cbbuf - nWritten);
+		if ( nBytes < 0 )
+		{
+			if ( errno == EINTR )
+				continue;
+			if ( (errno == EAGAIN || errno == EWOULDBLOCK) && NetWaitWritable(fd) == 0 )
+				continue;
+			return -1;
+		}
+		nWritten += nBytes;
+	}
+	return nWritten;
+}
+
+// Large send buffer for a printer connection, labels are sent in big bursts.
+void NetTuneStream(int fd)
+{
+	int		nSize = NETIO_SEND_BUFFER;
+
+	if ( setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &nSize, sizeof(nSize)) )
+		DebugPrintf("NetTuneStream: SO_SNDBUF - %s\n", strerror(errno));
+}
+
+// Hold back partial segments while a command and its payload are queued,
+// uncorking sends what is left. Not a TCP socket, nothing to do.
+void NetCork(int fd, BOOL bCork)
+{
+	int		nCork = bCork ? 1 : 0;
+
+	setsockopt(fd, IPPROTO_TCP, TCP_CORK, &nCork, sizeof(nCork));
+}
+
+// Copy count bytes at offset of fdIn to fdOut inside the kernel, falls back
+// to pread()/write() when sendfile() does not support the descriptors.
+ssize_t NetSendFile(int fdOut, int fdIn, off_t offset, size_t count)
+{
+	size_t		nSent = 0;
+	ssize_t		nBytes;
+	char		buffer[65536];
+
+	while ( nSent < count )
+	{
+		nBytes = sendfile(fdOut, fdIn, &offset, count - nSent);
+		if ( nBytes < 0 && errno == EINTR )
+			continue;
+		if ( nBytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && NetWaitWritable(fdOut) == 0 )
+			continue;
+		if ( nBytes < 0 && (errno == EINVAL || errno == ENOSYS) )
+			break;
+		if ( nBytes <= 0 )
+			return -1;
+		nSent += nBytes;
+	}
+
+	while ( nSent < count )
+	{
+		nBytes = pread(fdIn, buffer, min(sizeof(buffer), count - nSent), offset);
+		if ( nBytes < 0 && errno == EINTR )
+			continue;
+		if ( nBytes <= 0 || NetWriteAll(fdOut, buffer, nBytes) < 0 )
+			return -1;
+		offset += nBytes;
+		nSent += nBytes;
+	}
+	return nSent;
+}
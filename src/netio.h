@@ -0,0 +1,45 @@
+/*
+ * "netio.h 2026-10-17 10:12:40
+ *
+ *  network output routine declaration for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#ifndef _NETIO_H_
+#define _NETIO_H_
+
+#include "common.h"
+
+#define NETIO_DEFAULT_PORT			9100		// TSC raw print port
+#define NETIO_SEND_BUFFER			(1024 * 1024)	// SO_SNDBUF of printer connections
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int		NetOpenDeviceURI(const char *szURI);
+int		NetOpenUnixSocket(const char *szPath);
+int		NetListenUnixSocket(const char *szPath);
+ssize_t	NetWriteAll(int fd, const void *pbuf, size_t cbbuf);
+void	NetTuneStream(int fd);
+void	NetCork(int fd, BOOL bCork);
+ssize_t	NetSendFile(int fdOut, int fdIn, off_t offset, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// #ifndef _NETIO_H_
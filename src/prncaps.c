@@ -0,0 +1,85 @@
+/*
+ * "prncaps.c 2026-10-17 10:12:40
+ *
+ *  printer capability routine for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include "config.h"
+#include "common.h"
+#include "debug.h"
+#include "prncaps.h"
+
+static const char* GetCapsAttr(CUPSLIB_FUNCTION *cups, ppd_file_t *ppd, const char *pszSpec)
+{
+	ppd_attr_t		*attr;
+
+	if ( (attr = cups->ppdFindAttr(ppd, PPD_TSC_ATTR, pszSpec)) != NULL && attr->value )
+		return attr->value;
+	return NULL;
+}
+
+BOOL GetPrinterCaps(CUPSLIB_FUNCTION *cups, ppd_file_t *ppd, PRINTERCAPS *pCaps)
+{
+	const char		*pszValue;
+	ppd_attr_t		*attr;
+	int				i;
+
+	memset(pCaps, 0, sizeof(PRINTERCAPS));
+	pCaps->wLanguage = CAPS_LANGUAGE_TSPL2;
+	pCaps->wDpi = DPI_203;
+
+	if ( ppd == NULL )
+		return FALSE;
+
+	if ( (pszValue = GetCapsAttr(cups, ppd, PPD_TSCATTR_LANGUAGE)) != NULL && !strcasecmp(pszValue, "TSPL") )
+		pCaps->wLanguage = CAPS_LANGUAGE_TSPL;
+
+	// The paper width clips the raster, so it is taken only when the PPD
+	// agrees with it: no page size of the PPD may be wider
+	if ( (pszValue = GetCapsAttr(cups, ppd, PPD_TSCATTR_MAXPAPERWIDTH)) != NULL && atof(pszValue) > 0 )
+	{
+		pCaps->fMaxPaperWidth = atof(pszValue);
+		if ( ppd->variable_sizes && ppd->custom_max[0] > pCaps->fMaxPaperWidth )
+			pCaps->fMaxPaperWidth = 0;
+		for (i=0; i<ppd->num_sizes; i++)
+		{
+			if ( ppd->sizes[i].width > pCaps->fMaxPaperWidth )
+				pCaps->fMaxPaperWidth = 0;
+		}
+		if ( pCaps->fMaxPaperWidth == 0 )
+			DebugPrintf("CAPS: %s %s is narrower than a page size of the PPD, not used\n",
+						PPD_TSCATTR_MAXPAPERWIDTH, pszValue);
+	}
+
+	// Bands only for a model whose memory the PPD states, nothing is guessed
+	if ( (pszValue = GetCapsAttr(cups, ppd, PPD_TSCATTR_GRAPHICSMEMORY)) != NULL && atoi(pszValue) > 0 )
+	{
+		pCaps->dwGraphicsMemory = atoi(pszValue);
+		// Half the image buffer is left for the rest of the label
+		pCaps->dwMaxBitmap = pCaps->dwGraphicsMemory * 1024 / 2;
+	}
+	if ( (pszValue = GetCapsAttr(cups, ppd, PPD_TSCATTR_MAXBITMAPBYTES)) != NULL && atol(pszValue) > 0 )
+		pCaps->dwMaxBitmap = atol(pszValue);
+
+	if ( (attr = cups->ppdFindAttr(ppd, "DefaultResolution", NULL)) != NULL && attr->value && atoi(attr->value) > 0 )
+		pCaps->wDpi = atoi(attr->value);
+
+	DebugPrintf("CAPS %s: TSPL%s, %d dpi, width %.2f, memory %uKB, BITMAP %u\n",
+				ppd->modelname ? ppd->modelname : "", pCaps->wLanguage == CAPS_LANGUAGE_TSPL2 ? "2" : "", pCaps->wDpi, pCaps->fMaxPaperWidth,
+				pCaps->dwGraphicsMemory, pCaps->dwMaxBitmap);
+	return TRUE;
+}
@@ -0,0 +1,70 @@
+/*
+ * "prncaps.h 2026-10-17 10:12:40
+ *
+ *  printer capability routine declaration for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+/*
+	What one printer model can take, as the *TscAttr keys of its PPD
+	state it. Nothing is guessed for a key the PPD does not have:
+
+		*TscAttr tscLanguage: TSPL2
+		*TscAttr MaxPaperWidth: 334.49
+		*TscAttr GraphicsMemory: 8192			KB
+		*TscAttr MaxBitmapBytes: 1048576
+
+	The native dpi is the *DefaultResolution of the PPD. BITMAP is the
+	only transfer the filter has. It is sent in bands (dmMaxBitmap) only
+	when the PPD has GraphicsMemory or MaxBitmapBytes, and clipped to
+	MaxPaperWidth (dmMaxPaperWidth) only when no page size of the PPD is
+	wider.
+*/
+
+#ifndef _PRNCAPS_H_
+#define _PRNCAPS_H_
+
+#include "devmode.h"
+
+#define	PPD_TSCATTR_LANGUAGE		"tscLanguage"
+#define	PPD_TSCATTR_MAXPAPERWIDTH	"MaxPaperWidth"
+#define	PPD_TSCATTR_GRAPHICSMEMORY	"GraphicsMemory"
+#define	PPD_TSCATTR_MAXBITMAPBYTES	"MaxBitmapBytes"
+
+// PRINTERCAPS.wLanguage
+#define	CAPS_LANGUAGE_TSPL2			0
+#define	CAPS_LANGUAGE_TSPL			1
+
+typedef struct _PRINTERCAPS
+{
+	WORD		wLanguage;				// CAPS_LANGUAGE_*
+	WORD		wDpi;					// Native dpi
+	float		fMaxPaperWidth;			// Point, 0 = not known
+	DWORD		dwGraphicsMemory;		// KB, image buffer and downloaded graphics, 0 = not known
+	DWORD		dwMaxBitmap;			// Bytes of data in one BITMAP command, 0 = no limit
+} PRINTERCAPS;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BOOL		GetPrinterCaps(CUPSLIB_FUNCTION *cups, ppd_file_t *ppd, PRINTERCAPS *pCaps);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// #ifndef _PRNCAPS_H_
@@ -0,0 +1,54 @@
+/*
+ * "probe.h 2026-10-17 10:12:40
+ *
+ *  static tracepoint declaration for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+/*
+	USDT probes of provider "tscdriver", a nop in the code until a tracer
+	attaches. Without <sys/sdt.h> they are left out of the build.
+
+		raster__page__start		page, width, height, x dpi, y dpi
+		raster__page__end		page, width, height, bytes stored, result
+		raster__rows			bytes, rows decoded at once
+		gs__page				page, width, height, bytes of bits
+		output__write			bytes, bytes written, microseconds
+
+		bpftrace -e 'usdt:/usr/lib/cups/filter/rastertobarcodetspl:tscdriver:output__write
+					{ @us = hist(arg2); }'
+*/
+
+#ifndef _PROBE_H_
+#define _PROBE_H_
+
+#include "config.h"
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+
+#define	TSC_PROBE2(name, a1, a2)					DTRACE_PROBE2(tscdriver, name, a1, a2)
+#define	TSC_PROBE3(name, a1, a2, a3)				DTRACE_PROBE3(tscdriver, name, a1, a2, a3)
+#define	TSC_PROBE4(name, a1, a2, a3, a4)			DTRACE_PROBE4(tscdriver, name, a1, a2, a3, a4)
+#define	TSC_PROBE5(name, a1, a2, a3, a4, a5)		DTRACE_PROBE5(tscdriver, name, a1, a2, a3, a4, a5)
+#else
+#define	TSC_PROBE2(name, a1, a2)					do {} while (0)
+#define	TSC_PROBE3(name, a1, a2, a3)				do {} while (0)
+#define	TSC_PROBE4(name, a1, a2, a3, a4)			do {} while (0)
+#define	TSC_PROBE5(name, a1, a2, a3, a4, a5)		do {} while (0)
+#endif
+
+#endif	// #ifndef _PROBE_H_
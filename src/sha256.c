@@ -0,0 +1,160 @@
+/*
+ * "sha256.c 2026-10-17 10:12:40
+ *
+ *  SHA-256 routines for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+// FIPS 180-4, libcups 1.1 has no hash function we could load
+
+#include "config.h"
+#include "common.h"
+#include "sha256.h"
+
+#define ROTR(x, n)		(((x) >> (n)) | ((x) << (32 - (n))))
+
+static const DWORD g_K[64] =
+{
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static void Sha256Block(SHA256_CTX *ctx, const BYTE *p);
+
+void Sha256Init(SHA256_CTX *ctx)
+{
+	memset(ctx, 0, sizeof(SHA256_CTX));
+	ctx->state[0] = 0x6a09e667;
+	ctx->state[1] = 0xbb67ae85;
+	ctx->state[2] = 0x3c6ef372;
+	ctx->state[3] = 0xa54ff53a;
+	ctx->state[4] = 0x510e527f;
+	ctx->state[5] = 0x9b05688c;
+	ctx->state[6] = 0x1f83d9ab;
+	ctx->state[7] = 0x5be0cd19;
+}
+
+void Sha256Update(SHA256_CTX *ctx, const void *pbuf, size_t cbbuf)
+{
+	const BYTE	*p = (const BYTE*)pbuf;
+	DWORD		dwUsed = ctx->countLow % 64;
+
+	while ( cbbuf > 0 )
+	{
+		size_t	cb = min(cbbuf, 64 - dwUsed);
+
+		memcpy(ctx->buffer + dwUsed, p, cb);
+		dwUsed += cb;
+		p += cb;
+		cbbuf -= cb;
+
+		if ( ctx->countLow + cb < ctx->countLow )
+			ctx->countHigh ++;
+		ctx->countLow += cb;
+
+		if ( dwUsed == 64 )
+		{
+			Sha256Block(ctx, ctx->buffer);
+			dwUsed = 0;
+		}
+	}
+}
+
+void Sha256Final(SHA256_CTX *ctx, BYTE digest[SHA256_DIGEST_LENGTH])
+{
+	BYTE	pad[72];
+	DWORD	dwUsed = ctx->countLow % 64;
+	DWORD	dwPad = (dwUsed < 56 ? 56 : 120) - dwUsed;
+	DWORD	dwBitsHigh = (ctx->countHigh << 3) | (ctx->countLow >> 29);
+	DWORD	dwBitsLow = ctx->countLow << 3;
+	int		i;
+
+	memset(pad, 0, sizeof(pad));
+	pad[0] = 0x80;
+	for (i=0; i<4; i++)
+	{
+		pad[dwPad + i]     = (BYTE)(dwBitsHigh >> (24 - i * 8));
+		pad[dwPad + 4 + i] = (BYTE)(dwBitsLow >> (24 - i * 8));
+	}
+	Sha256Update(ctx, pad, dwPad + 8);
+
+	for (i=0; i<SHA256_DIGEST_LENGTH; i++)
+		digest[i] = (BYTE)(ctx->state[i / 4] >> (24 - (i % 4) * 8));
+}
+
+void Sha256String(const BYTE digest[SHA256_DIGEST_LENGTH], char szHex[SHA256_STRING_LENGTH])
+{
+	int		i;
+
+	for (i=0; i<SHA256_DIGEST_LENGTH; i++)
+		sprintf(szHex + i * 2, "%02x", digest[i]);
+}
+
+void Sha256Block(SHA256_CTX *ctx, const BYTE *p)
+{
+	DWORD	w[64];
+	DWORD	a, b, c, d, e, f, g, h;
+	DWORD	t1, t2;
+	int		i;
+
+	for (i=0; i<16; i++)
+		w[i] = ((DWORD)p[i*4] << 24) | ((DWORD)p[i*4+1] << 16) | ((DWORD)p[i*4+2] << 8) | p[i*4+3];
+	for (i=16; i<64; i++)
+	{
+		DWORD	s0 = ROTR(w[i-15], 7) ^ ROTR(w[i-15], 18) ^ (w[i-15] >> 3);
+		DWORD	s1 = ROTR(w[i-2], 17) ^ ROTR(w[i-2], 19) ^ (w[i-2] >> 10);
+
+		w[i] = w[i-16] + s0 + w[i-7] + s1;
+	}
+
+	a = ctx->state[0];
+	b = ctx->state[1];
+	c = ctx->state[2];
+	d = ctx->state[3];
+	e = ctx->state[4];
+	f = ctx->state[5];
+	g = ctx->state[6];
+	h = ctx->state[7];
+
+	for (i=0; i<64; i++)
+	{
+		t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + ((e & f) ^ (~e & g)) + g_K[i] + w[i];
+		t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	ctx->state[0] += a;
+	ctx->state[1] += b;
+	ctx->state[2] += c;
+	ctx->state[3] += d;
+	ctx->state[4] += e;
+	ctx->state[5] += f;
+	ctx->state[6] += g;
+	ctx->state[7] += h;
+}
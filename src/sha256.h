@@ -0,0 +1,50 @@
+/*
+ * "sha256.h 2026-10-17 10:12:40
+ *
+ *  SHA-256 declaration for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#ifndef _SHA256_H_
+#define _SHA256_H_
+
+#include "common.h"
+
+#define SHA256_DIGEST_LENGTH		32
+#define SHA256_STRING_LENGTH		(SHA256_DIGEST_LENGTH * 2 + 1)
+
+typedef struct _SHA256_CTX
+{
+	DWORD		state[8];
+	DWORD		countHigh;				// Message length in bytes
+	DWORD		countLow;
+	BYTE		buffer[64];
+} SHA256_CTX;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void	Sha256Init(SHA256_CTX *ctx);
+void	Sha256Update(SHA256_CTX *ctx, const void *pbuf, size_t cbbuf);
+void	Sha256Final(SHA256_CTX *ctx, BYTE digest[SHA256_DIGEST_LENGTH]);
+void	Sha256String(const BYTE digest[SHA256_DIGEST_LENGTH], char szHex[SHA256_STRING_LENGTH]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// #ifndef _SHA256_H_
@@ -0,0 +1,105 @@
+/*
+ * "pageindex.c 2026-10-17 10:12:40
+ *
+ *  million-page job test for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+/*
+	Parses a synthetic raster of a million pages of 70000 copies each
+	through ParseDocData, piped from rastergen, and checks that the page
+	index holds every page, that the label count does not wrap and that
+	the peak memory stays within a few bytes per page.
+
+		pageindex [pages]
+*/
+
+#define main filter_main
+#include "../filter/rastertotspl.c"
+#undef main
+
+#include <sys/resource.h>
+#include "mycups.h"
+
+#define TEST_PAGES			1000000
+#define TEST_COPIES			70000
+#define TEST_MAX_RSS_KB		(64 * 1024)		/* Peak resident set allowed */
+
+int main(int argc, char *argv[])
+{
+	DEVDATA			dev;
+	doc_t			doc;
+	ppd_file_t		ppd;
+	struct rusage	ru;
+	pageinfo_t		*pageinfo;
+	char			szCmd[64];
+	unsigned		nPages = argc > 1 ? strtoul(argv[1], NULL, 10) : TEST_PAGES;
+	FILE			*fp;
+	int				ret = 0;
+
+	memset(&dev, 0, sizeof(dev));
+	memset(&doc, 0, sizeof(doc));
+	memset(&ppd, 0, sizeof(ppd));
+	ppd.custom_max[0] = ppd.custom_max[1] = 10000;
+	dev.ppd = &ppd;
+	dev.lib_cups.cupsTempFile2 = (PFN_cupsTempFile2) my_cupsTempFile2;
+	dev.lib_cups.cupsFileClose = (PFN_cupsFileClose) my_cupsFileClose;
+	dev.lib_cups.cupsFileTell = (PFN_cupsFileTell) my_cupsFileTell;
+	dev.lib_cups.cupsFileWrite = (PFN_cupsFileWrite) my_cupsFileWrite;
+	dev.dm.dmPrintQuality = dev.dm.dmYResolution = 203;
+	dev.dm.dmCopies = 1;
+
+	snprintf(szCmd, sizeof(szCmd), "./rastergen %u %u", nPages, TEST_COPIES);
+	if ( (fp = popen(szCmd, "r")) == NULL )
+	{
+		perror(szCmd);
+		return 1;
+	}
+	if ( ParseDocData(&dev, fileno(fp), &doc) != 0 )
+	{
+		fprintf(stderr, "ParseDocData failed\n");
+		ret = 1;
+	}
+	if ( pclose(fp) != 0 )
+	{
+		fprintf(stderr, "%s failed\n", szCmd);
+		ret = 1;
+	}
+	getrusage(RUSAGE_SELF, &ru);
+
+	printf("pages=%u copies=%u labels=%.0f maxrss=%ld KB\n", doc.pages.count, dev.dm.dmCopies,
+			(double)dev.dm.dmDocPages * dev.dm.dmCopies, ru.ru_maxrss);
+
+	if ( doc.pages.count != nPages || dev.dm.dmDocPages != nPages || dev.dm.dmCopies != TEST_COPIES )
+	{
+		fprintf(stderr, "page or copy count wrapped\n");
+		ret = 1;
+	}
+	if ( (pageinfo = PageGet(&doc.pages, nPages - 1)) == NULL || pageinfo->length == 0
+		|| PageGet(&doc.pages, nPages) != NULL )
+	{
+		fprintf(stderr, "page index does not end at page %u\n", nPages);
+		ret = 1;
+	}
+	if ( ru.ru_maxrss > TEST_MAX_RSS_KB )
+	{
+		fprintf(stderr, "peak memory %ld KB over %d KB\n", ru.ru_maxrss, TEST_MAX_RSS_KB);
+		ret = 1;
+	}
+
+	FreeDocData(&dev, &doc);
+	return ret;
+}
@@ -0,0 +1,167 @@
+/*
+ * "rasterfuzz.c 2026-10-17 10:12:40
+ *
+ *  raster reader fuzz harness for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+/*
+	Feeds a raster stream through the same reader calls as ParseDocData.
+
+	Built with -DRASTER_LIBFUZZER it is a libFuzzer target:
+
+		clang -g -fsanitize=fuzzer,address -DRASTER_LIBFUZZER -D_TSPL -I. -Ifilter \
+			tests/rasterfuzz.c filter/raster.c libcommon.a -ldl
+		./a.out tests/corpus
+
+	Otherwise it is the check program, which replays every file of the
+	corpus. A file named bad-* must end on a rejected page header, any
+	other file must read to its end.
+*/
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <stdint.h>
+#include "raster.h"
+
+#define FUZZ_MAX_PAGES		64
+
+// Read every page as ParseDocData does, 1 at the end of the stream, -1 on a rejected header
+static int ReadRaster(const uint8_t *pData, size_t cbData)
+{
+	cups_page_header_t	header;
+	cups_raster_t		*ras;
+	unsigned char		*pRow;
+	unsigned			nPages, y;
+	FILE				*fp;
+	int					ret = 1;
+
+	if ( (fp = tmpfile()) == NULL )
+		return 1;
+	if ( cbData && fwrite(pData, 1, cbData, fp) != cbData )
+	{
+		fclose(fp);
+		return 1;
+	}
+	fflush(fp);
+	lseek(fileno(fp), 0, SEEK_SET);
+
+	if ( (ras = cupsRasterOpen(fileno(fp), CUPS_RASTER_READ)) != NULL )
+	{
+		for ( nPages = 0; nPages < FUZZ_MAX_PAGES && cupsRasterReadHeader(ras, &header); nPages++ )
+		{
+			if ( (pRow = malloc(header.cupsBytesPerLine)) == NULL )
+				break;
+			for ( y = 0; y < header.cupsHeight; y++ )
+			{
+				if ( cupsRasterReadPixels(ras, pRow, header.cupsBytesPerLine) < 1 )
+					break;
+			}
+			free(pRow);
+			if ( y < header.cupsHeight )
+				break;
+		}
+		if ( cupsRasterError(ras) )
+			ret = -1;
+		cupsRasterClose(ras);
+	}
+	fclose(fp);
+	return ret;
+}
+
+#ifdef RASTER_LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const uint8_t *pData, size_t cbData)
+{
+	ReadRaster(pData, cbData);
+	return 0;
+}
+
+#else
+
+static int ReplayFile(const char *szPath, const char *szName)
+{
+	uint8_t		*pData = NULL;
+	size_t		cbData = 0, cbRead;
+	FILE		*fp;
+	int			ret, bBad;
+
+	if ( (fp = fopen(szPath, "rb")) == NULL )
+	{
+		fprintf(stderr, "%s: cannot open\n", szPath);
+		return 1;
+	}
+	do
+	{
+		uint8_t *pNew = realloc(pData, cbData + 4096);
+		if ( pNew == NULL )
+			break;
+		pData = pNew;
+		cbRead = fread(pData + cbData, 1, 4096, fp);
+		cbData += cbRead;
+	} while ( cbRead == 4096 );
+	fclose(fp);
+
+	ret = ReadRaster(pData, cbData);
+	free(pData);
+
+	bBad = strncmp(szName, "bad-", 4) == 0;
+	if ( (ret < 0) != bBad )
+	{
+		fprintf(stderr, "%s: %s\n", szName, ret < 0 ? "header rejected" : "header not rejected");
+		return 1;
+	}
+	printf("%s: ok\n", szName);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	char			szDir[1024], szPath[2048];
+	const char		*szSrcDir = getenv("srcdir");
+	struct dirent	*pEntry;
+	DIR				*pDir;
+	int				nFailed = 0, nFiles = 0;
+
+	if ( argc > 1 )
+		snprintf(szDir, sizeof(szDir), "%s", argv[1]);
+	else
+		snprintf(szDir, sizeof(szDir), "%s/tests/corpus", szSrcDir ? szSrcDir : ".");
+
+	if ( (pDir = opendir(szDir)) == NULL )
+	{
+		fprintf(stderr, "%s: cannot open corpus\n", szDir);
+		return 1;
+	}
+	while ( (pEntry = readdir(pDir)) != NULL )
+	{
+		if ( pEntry->d_name[0] == '.' )
+			continue;
+		snprintf(szPath, sizeof(szPath), "%s/%s", szDir, pEntry->d_name);
+		nFailed += ReplayFile(szPath, pEntry->d_name);
+		nFiles++;
+	}
+	closedir(pDir);
+
+	printf("%d files, %d failed\n", nFiles, nFailed);
+	return nFailed || nFiles == 0;
+}
+
+#endif
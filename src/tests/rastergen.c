@@ -0,0 +1,77 @@
+/*
+ * "rastergen.c 2026-10-17 10:12:40
+ *
+ *  synthetic raster generator for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+/*
+	Writes a CUPS raster of tiny labels to stdout for load tests:
+
+		rastergen <pages> [copies] > job.ras
+
+	Each page is 16x2 dots at 203 dpi. The stream is almost all page
+	headers, about 1.8 GB for a million pages, so pipe it rather than
+	keep it. The filter sees the job as pages * copies labels.
+*/
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "raster.h"
+
+int main(int argc, char *argv[])
+{
+	cups_page_header_t	header;
+	cups_raster_t		*ras;
+	unsigned char		row[2] = { 0x80, 0x01 };
+	unsigned			nPages, i;
+
+	if ( argc < 2 || (nPages = strtoul(argv[1], NULL, 10)) == 0 )
+	{
+		fprintf(stderr, "Usage: rastergen <pages> [copies]\n");
+		return 1;
+	}
+
+	memset(&header, 0, sizeof(header));
+	header.cupsWidth = 16;
+	header.cupsHeight = 2;
+	header.cupsBytesPerLine = 2;
+	header.cupsBitsPerPixel = 1;
+	header.cupsBitsPerColor = 1;
+	header.cupsColorSpace = CUPS_CSPACE_K;
+	header.HWResolution[0] = header.HWResolution[1] = 203;
+	header.PageSize[0] = 6;
+	header.PageSize[1] = 1;
+	header.NumCopies = argc > 2 ? strtoul(argv[2], NULL, 10) : 1;
+
+	if ( (ras = cupsRasterOpen(fileno(stdout), CUPS_RASTER_WRITE)) == NULL )
+		return 1;
+	for ( i = 0; i < nPages; i++ )
+	{
+		if ( !cupsRasterWriteHeader(ras, &header)
+			|| cupsRasterWritePixels(ras, row, sizeof(row)) < 1
+			|| cupsRasterWritePixels(ras, row, sizeof(row)) < 1 )
+		{
+			cupsRasterClose(ras);
+			return 1;
+		}
+	}
+	cupsRasterClose(ras);
+	return 0;
+}
@@ -0,0 +1,735 @@
+/*
+ * "tsplenc.c 2026-10-17 10:12:40
+ *
+ *  TSPL encoder library routines for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include "config.h"
+#include "common.h"
+#include "tsplenc.h"
+
+#define	DRAWMODE_COPY			0
+#define	DRAWMODE_OR				1
+#define	DRAWMODE_XOR			2
+
+#define DIRECTION_RIGHT_BOTTOM	0
+#define DIRECTION_LEFT_TOP		1
+
+#define	TSPL_SET_TEAR				"SET TEAR %s\r\n"
+#define	TSPL_SET_PEEL				"SET PEEL %s\r\n"
+#define	TSPL_SET_CUTTER				"SET CUTTER %s\r\n"
+#define	TSPL_SET_PARTIAL_CUTTER		"SET PARTIAL_CUTTER %s\r\n"
+#define	TSPL_CUT					"CUT\r\n"
+
+#define	TSPLENC_BUFFER				65536		// Inverted rows handed to the sink at once
+#define	TSPLENC_MIN_LENGTH			(0.25*72)	// Point, shortest auto-length label
+#define	TSPLENC_DECIMAL_LENGTH		32			// Chars of a number by TsplDecimal()
+
+struct _TSPLJOB
+{
+	DEVMODE		*pdm;
+	TSPLSINK	sink;
+	TSPLSETUP	*pSetup;
+	BOOL		bError;					// The sink failed, nothing more is sent
+	BOOL		bPageStart;				// CLS of the page is not sent yet
+	float		fPageLength;			// Point, SIZE of the page
+	float		fSizeWidth;				// Point, SIZE and GAP the printer has now
+	float		fSizeLength;
+	float		fGapHeight;
+	float		fGapOffset;
+	WORD		wSpeed;					// 1/10 inch/sec, SPEED the printer has now
+	BOOL		bCutAtEnd;				// dmCutAtEnd, cutter off and CUT after the job
+};
+
+static int TsplSendUserCommand(TSPLJOB *pJob, DWORD dwField);
+static int TsplSendSetup(TSPLJOB *pJob, int nSetup, const char* strfmt, ...);
+static int TsplSendSize(TSPLJOB *pJob, float fLength);
+static int TsplSendGap(TSPLJOB *pJob);
+static int TsplSendSpeed(TSPLJOB *pJob);
+static void TsplSendPageStart(TSPLJOB *pJob, int nDots);
+static BOOL TsplAutoLength(TSPLJOB *pJob);
+static BOOL TsplRowBlank(const BYTE *pRow, int nWidth, BYTE blank);
+static int TsplInkedRows(const BYTE *pRows, int nWidth, int nHeight, size_t cbStride, BYTE blank);
+static int TsplInkedRowsFile(int nWidth, int nHeight, int fd, off_t offset);
+static int TsplBitmapBand(TSPLJOB *pJob, int iWidth, int nHeight);
+static const char* TsplDecimal(char *psz, double d, int nDigits);
+
+TSPLJOB* TsplJobCreate(DEVMODE *pdm, const TSPLSINK *pSink, TSPLSETUP *pSetup)
+{
+	TSPLJOB		*pJob;
+
+	if ( pdm == NULL || pSink == NULL || pSink->pfnWrite == NULL )
+		return NULL;
+
+	if ( (pJob = MEMALLOC(sizeof(TSPLJOB))) != NULL )
+	{
+		pJob->pdm = pdm;
+		pJob->sink = *pSink;
+		pJob->pSetup = pSetup;
+
+		// Until a job start says otherwise the printer is set up for pdm
+		pJob->fSizeWidth = pdm->dmPaperWidth;
+		pJob->fSizeLength = pdm->dmPaperLength;
+		pJob->fGapHeight = pdm->dmGapHeight;
+		pJob->fGapOffset = pdm->dmGapOffset;
+		pJob->wSpeed = pdm->dmPrintSpeed;
+	}
+	return pJob;
+}
+
+void TsplJobDestroy(TSPLJOB *pJob)
+{
+	MEMFREE(pJob);
+}
+
+DEVMODE* TsplJobDevmode(TSPLJOB *pJob)
+{
+	return pJob->pdm;
+}
+
+int TsplJobStart(TSPLJOB *pJob)
+{
+	DEVMODE		*pdm = pJob->pdm;
+	char		sz1[TSPLENC_DECIMAL_LENGTH];
+
+	// Set User Command - Start Job
+	TsplSendUserCommand(pJob, DM_CMDSTARTJOB);
+
+	// User commands may change the setup behind our back
+	if ( pJob->pSetup && (pdm->dmFields & DM_CMDSTARTJOB) && pdm->dmCmdStartJobLength > 0 )
+		memset(pJob->pSetup, 0, sizeof(TSPLSETUP));
+
+	// Set Lable Size
+	TsplSendSize(pJob, pdm->dmPaperLength);
+
+	// Set Gap
+	TsplSendGap(pJob);
+
+	// Set Speed
+	if ( pdm->dmFields & DM_PRINTSPEED )
+		TsplSendSpeed(pJob);
+
+	// Set Density
+	if ( pdm->dmFields & DM_DARKNESS )
+		TsplSendSetup(pJob, TSPLSETUP_DENSITY, "DENSITY %d\r\n", pdm->dmDarkness);
+
+	// Set Ribbon
+	switch ( pdm->dmMediaMethod )
+	{
+	case DMMEDIAMETHOD_DIRECT:
+		TsplSendSetup(pJob, TSPLSETUP_RIBBON, "SET RIBBON OFF\r\n");
+		break;
+	case DMMEDIAMETHOD_TRANSFER:
+		TsplSendSetup(pJob, TSPLSETUP_RIBBON, "SET RIBBON ON\r\n");
+		break;
+	}
+
+	// Set Direction
+	{
+		int		n = DIRECTION_LEFT_TOP;
+		int		m = DMMIRRORIMAGE_OFF;
+
+		// Upside down is printed the other way round, the bitmap stays as it is
+		if ( (pdm->dmFields & DM_ORIENTATION)
+			&& (pdm->dmOrientation == DMORIENT_PORTRAIT_180 || pdm->dmOrientation == DMORIENT_LANDSCAPE_180) )
+			n = DIRECTION_RIGHT_BOTTOM;
+
+		if ( pdm->dmFields & DM_MIRRORIMAGE )
+			m = pdm->dmMirrorImage;
+
+		TsplSendSetup(pJob, TSPLSETUP_DIRECTION, "DIRECTION %d,%d\r\n", n, m);
+	}
+
+	// Set Reference
+	TsplSendSetup(pJob, TSPLSETUP_REFERENCE, "REFERENCE %.0f,%.0f\r\n",
+					POINT2DOT((double)pdm->dmAdjustHorizontal, pdm->dmPrintQuality),
+					POINT2DOT((double)pdm->dmAdjustVertical, pdm->dmYResolution));
+
+	// Set Offset
+	if ( pdm->dmMetric == DMMETRIC_INCH )
+		TsplSendSetup(pJob, TSPLSETUP_OFFSET, "OFFSET %s\r\n", TsplDecimal(sz1, POINT2INCH(pdm->dmFeedOffset), 3));
+	else
+		TsplSendSetup(pJob, TSPLSETUP_OFFSET, "OFFSET %s mm\r\n", TsplDecimal(sz1, POINT2MM(pdm->dmFeedOffset), 1));
+
+	// Set Shift
+	TsplSendSetup(pJob, TSPLSETUP_SHIFT, "SHIFT %.0f\r\n", POINT2DOT((double)pdm->dmVerticalOffset, pdm->dmYResolution));
+
+	// Set Action
+	{
+		char	szON[] = "ON";
+		char	szOFF[] = "OFF";
+		char	szNumber[16] = "1";
+
+		const char	*szTear		= szOFF;
+		const char	*szPeel		= szOFF;
+		const char	*szCut		= szOFF;
+		const char	*szPartCut	= szOFF;
+
+		// Cut after job without the label count: the cutter stays off and
+		// TsplJobEnd() cuts. There is no partial cut on command.
+		pJob->bCutAtEnd = pdm->dmOccurrence == DMOCCURRENCE_JOB && pdm->dmCutAtEnd == DMCUTATEND_ON
+							&& pdm->dmPostAction == DMPOSTACTION_CUT;
+
+		switch ( pdm->dmOccurrence )
+		{
+		case DMOCCURRENCE_EVERY:		// After Every Page
+			break;
+		case DMOCCURRENCE_COPIES:		// After Identical Copies
+			sprintf(szNumber, "%u", pdm->dmCopies);
+			break;
+		case DMOCCURRENCE_JOB:			// After Job
+			sprintf(szNumber, "%u", pdm->dmCopies * pdm->dmDocPages);
+			break;
+		case DMOCCURRENCE_SPECIFIED:	// After Specified interval
+			sprintf(szNumber, "%u", pdm->dmCutInterval);
+			break;
+		}
+
+		switch ( pdm->dmPostAction )
+		{
+		case DMPOSTACTION_NONE:			// None
+			break;
+		case DMPOSTACTION_TEAROFF:		// Tear Off
+			szTear = szON;
+			break;
+		case DMPOSTACTION_PEELOFF:		// Peel Off
+			szPeel = szON;
+			break;
+		case DMPOSTACTION_CUT:			// Cut
+			if ( !pJob->bCutAtEnd )
+				szCut = szNumber;
+			break;
+		case DMPOSTACTION_PARTIAL:		// Partial Cut
+			szPartCut = szNumber;
+			break;
+		}
+
+		// Everything off first, so two actions are never on at once
+		{
+			const char	*szCmds[][2] = {
+				{TSPL_SET_TEAR, szTear},
+				{TSPL_SET_PEEL, szPeel},
+				{TSPL_SET_CUTTER, szCut},
+				{TSPL_SET_PARTIAL_CUTTER, szPartCut},
+			};
+			int			i;
+			for ( i=0; i<ARRAYCOUNT(szCmds); i++)
+			{
+				if ( szCmds[i][1] == szOFF )
+				{
+					TsplSendSetup(pJob, TSPLSETUP_TEAR + i, szCmds[i][0], szCmds[i][1]);
+				}
+			}
+			for ( i=0; i<ARRAYCOUNT(szCmds); i++)
+			{
+				if ( szCmds[i][1] != szOFF )
+				{
+					TsplSendSetup(pJob, TSPLSETUP_TEAR + i, szCmds[i][0], szCmds[i][1]);
+				}
+			}
+		}
+	}
+
+	// Every setup command is in pSetup now
+	if ( pJob->pSetup )
+		pJob->pSetup->bLoaded = TRUE;
+
+	return pJob->bError ? -1 : 0;
+}
+
+// Labels of a job sent without its preamble into a stream another job
+// left the printer in. SIZE, GAP and SPEED go with the first page.
+int TsplJobAppend(TSPLJOB *pJob)
+{
+	pJob->fSizeWidth = -1;
+	pJob->fSizeLength = -1;
+	pJob->fGapHeight = -1;
+	pJob->fGapOffset = -1;
+	pJob->wSpeed = 0;
+	return pJob->bError ? -1 : 0;
+}
+
+// Cut or partial cut after every nLabels labels from here on. The printer
+// counts the labels again from this command, as from the job preamble.
+int TsplJobCutInterval(TSPLJOB *pJob, unsigned nLabels)
+{
+	DEVMODE		*pdm = pJob->pdm;
+	char		szNumber[16];
+
+	sprintf(szNumber, "%u", nLabels);
+	if ( pdm->dmPostAction == DMPOSTACTION_CUT && !pJob->bCutAtEnd )
+		TsplSendSetup(pJob, TSPLSETUP_CUTTER, TSPL_SET_CUTTER, szNumber);
+	else if ( pdm->dmPostAction == DMPOSTACTION_PARTIAL )
+		TsplSendSetup(pJob, TSPLSETUP_PARTIAL_CUTTER, TSPL_SET_PARTIAL_CUTTER, szNumber);
+
+	return pJob->bError ? -1 : 0;
+}
+
+int TsplJobEnd(TSPLJOB *pJob)
+{
+	// The labels may have come from elsewhere, as in a label session
+	if ( pJob->bCutAtEnd )
+		TsplWrite(pJob, TSPL_CUT, strlen(TSPL_CUT));
+
+	// Set User Command - End Job
+	TsplSendUserCommand(pJob, DM_CMDENDJOB);
+
+	return pJob->bError ? -1 : 0;
+}
+
+// CLS waits for the first bitmap, an auto-length page needs its SIZE before it
+int TsplPageStart(TSPLJOB *pJob)
+{
+	pJob->bPageStart = TRUE;
+
+	return pJob->bError ? -1 : 0;
+}
+
+int TsplPageEnd(TSPLJOB *pJob)
+{
+	DEVMODE		*pdm = pJob->pdm;
+
+	TsplSendPageStart(pJob, -1);
+
+	// REVERSE
+	if( (pdm->dmFields & DM_NEGATIVEIMAGE) && (pdm->dmNegativeImage != DMNEGATIVEIMAGE_OFF))
+	{
+		TsplPrintf(pJob, "REVERSE 0,0,%.0f,%.0f\r\n",
+						POINT2DOT(pdm->dmPaperWidth, pdm->dmPrintQuality),
+						POINT2DOT(pJob->fPageLength, pdm->dmYResolution));
+	}
+
+	// PRINT
+	TsplPrintf(pJob, "PRINT %d,%u\r\n", 1, pdm->dmCollate ? 1 : pdm->dmCopies);
+
+	// Set User Command - End Label
+	TsplSendUserCommand(pJob, DM_CMDENDLABEL);
+
+	return pJob->bError ? -1 : 0;
+}
+
+// nHeight rows of nWidth dots, cbStride bytes apart.
+int TsplPageBitmap(TSPLJOB *pJob, int x, int y, int nWidth, int nHeight,
+					const BYTE *pRows, size_t cbStride, DWORD dwFlags)
+{
+	int		iWidth = WIDTHBYTES_8(nWidth);	// The width of the image in bytes
+	BYTE	*pBuffer = NULL;
+	int		nBand;
+	int		i, j, b;
+
+	// Trailing blank rows are left out of an auto-length page
+	if ( TsplAutoLength(pJob) )
+		nHeight = TsplInkedRows(pRows, nWidth, nHeight, cbStride, (dwFlags & TSPLBITMAP_PRINTER) ? 0xFF : 0x00);
+	TsplSendPageStart(pJob, y + max(nHeight, 0));
+	if ( nHeight <= 0 && TsplAutoLength(pJob) )
+		return pJob->bError ? -1 : 0;
+
+	// One BITMAP command per band the printer can take
+	nBand = TsplBitmapBand(pJob, iWidth, nHeight);
+	for (b=0; b<nHeight; b+=nBand)
+	{
+		const BYTE	*pBand = pRows + cbStride * b;
+		int			nRows = min(nBand, nHeight - b);
+
+		TsplPrintf(pJob, "BITMAP %d,%d,%d,%d,%d,", x, y + b, iWidth, nRows, DRAWMODE_OR);
+
+		if ( dwFlags & TSPLBITMAP_PRINTER )
+		{
+			// The caller's rows go to the sink as they are
+			if ( cbStride == iWidth )
+				TsplWrite(pJob, pBand, (size_t)iWidth * nRows);
+			else
+			{
+				for (i=0; i<nRows; i++)
+					TsplWrite(pJob, pBand + cbStride * i, iWidth);
+			}
+		}
+		else
+		{
+			int		nBuffer = max(1, TSPLENC_BUFFER / max(iWidth, 1));
+
+			if ( pBuffer == NULL && (pBuffer = MEMALLOC((size_t)iWidth * nBuffer)) == NULL )
+			{
+				pJob->bError = TRUE;
+				return -1;
+			}
+			for (i=0; i<nRows; i+=nBuffer)
+			{
+				int		n = min(nBuffer, nRows - i);
+				BYTE	*p = pBuffer;
+
+				for (j=0; j<n; j++)
+				{
+					const BYTE	*pRow = pBand + cbStride * (i + j);
+					int			k;
+
+					for (k=0; k<iWidth; k++)
+						*p++ = ~pRow[k];
+				}
+				TsplWrite(pJob, pBuffer, (size_t)iWidth * n);
+			}
+		}
+
+		TsplWrite(pJob, "\r\n", 2);
+	}
+	MEMFREE(pBuffer);
+	return pJob->bError ? -1 : 0;
+}
+
+// Rows already in printer order, iWidth * nHeight bytes at offset of fd.
+int TsplPageBitmapFile(TSPLJOB *pJob, int x, int y, int nWidth, int nHeight, int fd, off_t offset)
+{
+	int		iWidth = WIDTHBYTES_8(nWidth);
+	int		nBand;
+	int		b;
+	size_t	count;
+
+	if ( TsplAutoLength(pJob) )
+		nHeight = TsplInkedRowsFile(nWidth, nHeight, fd, offset);
+	TsplSendPageStart(pJob, y + max(nHeight, 0));
+	if ( nHeight <= 0 && TsplAutoLength(pJob) )
+		return pJob->bError ? -1 : 0;
+
+	nBand = TsplBitmapBand(pJob, iWidth, nHeight);
+	for (b=0; b<nHeight && !pJob->bError; b+=nBand)
+	{
+		int		nRows = min(nBand, nHeight - b);
+
+		count = (size_t)iWidth * nRows;
+		TsplPrintf(pJob, "BITMAP %d,%d,%d,%d,%d,", x, y + b, iWidth, nRows, DRAWMODE_OR);
+
+		if ( !pJob->bError && pJob->sink.pfnSendFile )
+		{
+			if ( pJob->sink.pfnSendFile(pJob->sink.pContext, fd, offset, count) != count )
+				pJob->bError = TRUE;
+			offset += count;
+		}
+		else if ( !pJob->bError )
+		{
+			char		buffer[TSPLENC_BUFFER];
+			ssize_t		nBytes;
+
+			while ( count > 0 )
+			{
+				if ( (nBytes = pread(fd, buffer, min(count, sizeof(buffer)), offset)) <= 0 )
+				{
+					if ( nBytes < 0 && errno == EINTR )
+						continue;
+					pJob->bError = TRUE;
+					break;
+				}
+				if ( TsplWrite(pJob, buffer, nBytes) < 0 )
+					break;
+				offset += nBytes;
+				count -= nBytes;
+			}
+		}
+
+		TsplWrite(pJob, "\r\n", 2);
+	}
+	return pJob->bError ? -1 : 0;
+}
+
+// No human readable line and no rotation, x,y is the top left of the bars
+int TsplPageBarcode(TSPLJOB *pJob, int x, int y, const char *pszType, int nHeight,
+					int nNarrow, int nWide, const char *pszData)
+{
+	TsplSendPageStart(pJob, y + nHeight);
+	TsplPrintf(pJob, "BARCODE %d,%d,\"%s\",%d,0,0,%d,%d,\"%s\"\r\n",
+					x, y, pszType, nHeight, nNarrow, nWide, pszData);
+	return pJob->bError ? -1 : 0;
+}
+
+int TsplWrite(TSPLJOB *pJob, const void *pbuf, size_t cbbuf)
+{
+	if ( pJob->bError )
+		return -1;
+	if ( cbbuf == 0 )
+		return 0;
+
+	if ( pJob->sink.pfnWrite(pJob->sink.pContext, pbuf, cbbuf) != cbbuf )
+	{
+		pJob->bError = TRUE;
+		return -1;
+	}
+	return cbbuf;
+}
+
+int TsplPrintf(TSPLJOB *pJob, const char *strfmt, ...)
+{
+	char	szCmd[256];
+	char	*p = szCmd;
+	int		iRtn;
+	va_list	args;
+
+	va_start(args, strfmt);
+	iRtn = vsnprintf(szCmd, sizeof(szCmd), strfmt, args);
+	va_end(args);
+
+	if ( iRtn < 0 )
+		return -1;
+	if ( iRtn >= sizeof(szCmd) )
+	{
+		if ( (p = MEMALLOC(iRtn + 1)) == NULL )
+			return -1;
+		va_start(args, strfmt);
+		vsnprintf(p, iRtn + 1, strfmt, args);
+		va_end(args);
+	}
+
+	iRtn = TsplWrite(pJob, p, iRtn);
+	if ( p != szCmd )
+		MEMFREE(p);
+	return iRtn;
+}
+
+int TsplSendUserCommand(TSPLJOB *pJob, DWORD dwField)
+{
+	DEVMODE	*pdm = pJob->pdm;
+	WORD	wLength = 0;
+	LPBYTE	pCmdDat = NULL;
+
+	if ( pdm->dmFields & dwField )
+	{
+		switch (dwField)
+		{
+		case DM_CMDSTARTJOB:
+			pCmdDat = pdm->dmCmdStartJob;
+			wLength = pdm->dmCmdStartJobLength;
+			break;
+		case DM_CMDSTARTLABEL:
+			pCmdDat = pdm->dmCmdStartLable;
+			wLength = pdm->dmCmdStartLabelLength;
+			break;
+		case DM_CMDENDLABEL:
+			pCmdDat = pdm->dmCmdEndLable;
+			wLength = pdm->dmCmdEndLabelLength;
+			break;
+		case DM_CMDENDJOB:
+			pCmdDat = pdm->dmCmdEndJob;
+			wLength = pdm->dmCmdEndJobLength;
+			break;
+		}
+	}
+
+	if ( pCmdDat && wLength > 0 )
+		return TsplWrite(pJob, pCmdDat, wLength);
+	return 0;
+}
+
+// Send a job setup command unless the printer already has it from a previous job.
+int TsplSendSetup(TSPLJOB *pJob, int nSetup, const char* strfmt, ...)
+{
+	char	szCmd[TSPLSETUP_COMMAND_LENGTH];
+	va_list	args;
+	int		iRtn;
+
+	va_start(args, strfmt);
+	iRtn = vsnprintf(szCmd, sizeof(szCmd), strfmt, args);
+	va_end(args);
+
+	if ( iRtn < 0 || iRtn >= sizeof(szCmd) )
+		return -1;
+
+	if ( pJob->pSetup )
+	{
+		if ( pJob->pSetup->bLoaded && !strcmp(pJob->pSetup->szCmds[nSetup], szCmd) )
+			return 0;
+		strcpy(pJob->pSetup->szCmds[nSetup], szCmd);
+	}
+
+	return TsplWrite(pJob, szCmd, iRtn);
+}
+
+int TsplSendSize(TSPLJOB *pJob, float fLength)
+{
+	DEVMODE		*pdm = pJob->pdm;
+	char		sz1[TSPLENC_DECIMAL_LENGTH];
+	char		sz2[TSPLENC_DECIMAL_LENGTH];
+
+	pJob->fSizeWidth = pdm->dmPaperWidth;
+	pJob->fSizeLength = fLength;
+
+	if ( pdm->dmMetric == DMMETRIC_INCH )
+		return TsplSendSetup(pJob, TSPLSETUP_SIZE, "SIZE %s,%s\r\n",
+								TsplDecimal(sz1, POINT2INCH(pdm->dmPaperWidth), 3), TsplDecimal(sz2, POINT2INCH(fLength), 3));
+	return TsplSendSetup(pJob, TSPLSETUP_SIZE, "SIZE %s mm,%s mm\r\n",
+							TsplDecimal(sz1, POINT2MM(pdm->dmPaperWidth), 1), TsplDecimal(sz2, POINT2MM(fLength), 1));
+}
+
+int TsplSendGap(TSPLJOB *pJob)
+{
+	DEVMODE		*pdm = pJob->pdm;
+	char		sz1[TSPLENC_DECIMAL_LENGTH];
+	char		sz2[TSPLENC_DECIMAL_LENGTH];
+
+	pJob->fGapHeight = pdm->dmGapHeight;
+	pJob->fGapOffset = pdm->dmGapOffset;
+
+	switch ( pdm->dmMediaType )
+	{
+	case DMMEDIATYPE_GAPS:			// Label with Gaps
+		if ( pdm->dmMetric == DMMETRIC_INCH )
+			return TsplSendSetup(pJob, TSPLSETUP_GAP, "GAP %s,%s\r\n",
+									TsplDecimal(sz1, POINT2INCH(pdm->dmGapHeight), 3), TsplDecimal(sz2, POINT2INCH(pdm->dmGapOffset), 3));
+		return TsplSendSetup(pJob, TSPLSETUP_GAP, "GAP %s mm,%s mm\r\n",
+								TsplDecimal(sz1, POINT2MM(pdm->dmGapHeight), 1), TsplDecimal(sz2, POINT2MM(pdm->dmGapOffset), 1));
+	case DMMEDIATYPE_MARK:			// Label with Mark
+		if ( pdm->dmMetric == DMMETRIC_INCH )
+			return TsplSendSetup(pJob, TSPLSETUP_GAP, "BLINE %s,%s\r\n",
+									TsplDecimal(sz1, POINT2INCH(pdm->dmGapHeight), 3), TsplDecimal(sz2, POINT2INCH(pdm->dmGapOffset), 3));
+		return TsplSendSetup(pJob, TSPLSETUP_GAP, "BLINE %s mm,%s mm\r\n",
+								TsplDecimal(sz1, POINT2MM(pdm->dmGapHeight), 1), TsplDecimal(sz2, POINT2MM(pdm->dmGapOffset), 1));
+	case DMMEDIATYPE_CONTINUE:		// Continue
+		return TsplSendSetup(pJob, TSPLSETUP_GAP, "GAP 0,0\r\n");
+	}
+	return 0;
+}
+
+int TsplSendSpeed(TSPLJOB *pJob)
+{
+	DEVMODE		*pdm = pJob->pdm;
+
+	pJob->wSpeed = pdm->dmPrintSpeed;
+
+	if ( pdm->dmPrintSpeed % 10 )
+		return TsplSendSetup(pJob, TSPLSETUP_SPEED, "SPEED %d.%d\r\n", pdm->dmPrintSpeed / 10, pdm->dmPrintSpeed % 10);
+	return TsplSendSetup(pJob, TSPLSETUP_SPEED, "SPEED %d\r\n", pdm->dmPrintSpeed / 10);
+}
+
+/*
+	nDots is the bottom of the content, -1 when unknown. The page geometry
+	and speed in pdm may change from page to page, SIZE, GAP and SPEED are
+	sent again only when they did.
+*/
+void TsplSendPageStart(TSPLJOB *pJob, int nDots)
+{
+	DEVMODE		*pdm = pJob->pdm;
+
+	if ( !pJob->bPageStart )
+		return;
+	pJob->bPageStart = FALSE;
+
+	pJob->fPageLength = pdm->dmPaperLength;
+	if ( nDots >= 0 && TsplAutoLength(pJob) )
+	{
+		float	fLength = (float)nDots * 72 / pdm->dmYResolution + pdm->dmAutoLengthMargin;
+
+		pJob->fPageLength = min(max(fLength, TSPLENC_MIN_LENGTH), pdm->dmPaperLength);
+	}
+
+	if ( pJob->fSizeWidth != pdm->dmPaperWidth || pJob->fSizeLength != pJob->fPageLength )
+		TsplSendSize(pJob, pJob->fPageLength);
+	if ( pJob->fGapHeight != pdm->dmGapHeight || pJob->fGapOffset != pdm->dmGapOffset )
+		TsplSendGap(pJob);
+	if ( (pdm->dmFields & DM_PRINTSPEED) && pJob->wSpeed != pdm->dmPrintSpeed )
+		TsplSendSpeed(pJob);
+
+	// Cls
+	TsplWrite(pJob, "CLS\r\n", 5);
+
+	// Set User Command - Start Label
+	TsplSendUserCommand(pJob, DM_CMDSTARTLABEL);
+}
+
+BOOL TsplAutoLength(TSPLJOB *pJob)
+{
+	DEVMODE		*pdm = pJob->pdm;
+
+	return pdm->dmAutoLength == DMAUTOLENGTH_ON && pdm->dmMediaType == DMMEDIATYPE_CONTINUE
+			&& pdm->dmYResolution > 0;
+}
+
+// Bits past nWidth in the last byte do not count
+BOOL TsplRowBlank(const BYTE *pRow, int nWidth, BYTE blank)
+{
+	int		iWidth = WIDTHBYTES_8(nWidth);
+	BYTE	mask = (BYTE)(0xFF << ((8 - nWidth % 8) % 8));
+	int		i;
+
+	for (i=0; i<iWidth - 1; i++)
+	{
+		if ( pRow[i] != blank )
+			return FALSE;
+	}
+	return iWidth == 0 || ((pRow[iWidth - 1] ^ blank) & mask) == 0;
+}
+
+// Rows up to the last one with a dot in it
+int TsplInkedRows(const BYTE *pRows, int nWidth, int nHeight, size_t cbStride, BYTE blank)
+{
+	while ( nHeight > 0 && TsplRowBlank(pRows + cbStride * (nHeight - 1), nWidth, blank) )
+		nHeight --;
+	return nHeight;
+}
+
+// The same for rows in printer order in a file, read from the bottom up
+int TsplInkedRowsFile(int nWidth, int nHeight, int fd, off_t offset)
+{
+	int		iWidth = WIDTHBYTES_8(nWidth);
+	int		nRows = max(1, TSPLENC_BUFFER / max(iWidth, 1));
+	BYTE	*pBuffer;
+	int		nInked = 0;
+	int		nLast = nHeight;
+
+	if ( iWidth == 0 || (pBuffer = MEMALLOC((size_t)iWidth * nRows)) == NULL )
+		return nHeight;
+
+	while ( nLast > 0 && nInked == 0 )
+	{
+		int		nFirst = max(0, nLast - nRows);
+		size_t	cb = (size_t)iWidth * (nLast - nFirst);
+
+		// Unreadable rows are sent as they are
+		if ( pread(fd, pBuffer, cb, offset + (off_t)iWidth * nFirst) != cb )
+		{
+			nInked = nLast;
+			break;
+		}
+		nInked = TsplInkedRows(pBuffer, nWidth, nLast - nFirst, iWidth, 0xFF);
+		if ( nInked )
+			nInked += nFirst;
+		nLast = nFirst;
+	}
+
+	MEMFREE(pBuffer);
+	return nInked;
+}
+
+// Rows of one BITMAP command, dmMaxBitmap bytes of data at most
+int TsplBitmapBand(TSPLJOB *pJob, int iWidth, int nHeight)
+{
+	DWORD	dwMax = pJob->pdm->dmMaxBitmap;
+
+	if ( dwMax == 0 || iWidth == 0 || (size_t)iWidth * nHeight <= dwMax )
+		return max(nHeight, 1);
+	return max(1, (int)(dwMax / iWidth));
+}
+
+// d with nDigits (1 to 3) decimals after a '.'. printf would use the decimal
+// point of the locale, which a host program may have set to ','.
+const char* TsplDecimal(char *psz, double d, int nDigits)
+{
+	static const long	lScale[] = { 1, 10, 100, 1000 };
+	long long			llValue;
+
+	nDigits = max(1, min(nDigits, 3));
+	llValue = (long long)((d < 0 ? -d : d) * lScale[nDigits] + 0.5);
+	snprintf(psz, TSPLENC_DECIMAL_LENGTH, "%s%lld.%0*lld", d < 0 && llValue ? "-" : "",
+				llValue / lScale[nDigits], nDigits, llValue % lScale[nDigits]);
+	return psz;
+}
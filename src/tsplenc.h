@@ -0,0 +1,129 @@
+/*
+ * "tsplenc.h 2026-10-17 10:12:40
+ *
+ *  TSPL encoder library declaration for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+/*
+	libtsplenc turns a DEVMODE and 1bpp label images into a TSPL stream.
+
+	It has no global state and does no I/O of its own: every job writes
+	through the sink it was created with, so one process may encode jobs
+	for many printers at once, one thread per job. Numbers are formatted
+	without the locale of the host. The CUPS library is not needed, only
+	the DEVMODE declaration.
+
+		TsplJobCreate
+		TsplJobStart / TsplJobAppend
+			TsplPageStart
+			TsplPageBitmap / TsplPageBitmapFile / TsplPageBarcode
+			TsplPageEnd
+			...
+		TsplJobEnd
+		TsplJobDestroy
+
+	On continuous media with dmAutoLength the first bitmap of a page,
+	less its trailing blank rows, sets the SIZE of the page. A cut after
+	the job with dmCutAtEnd is a CUT from TsplJobEnd, so the preamble
+	does not need the label count. The raster filter still reads the
+	whole document before it starts the job.
+	A bitmap larger than dmMaxBitmap, what the model takes in one
+	command, is sent as bands of BITMAP commands one under the other.
+*/
+
+#ifndef _TSPLENC_H_
+#define _TSPLENC_H_
+
+#include "devmode.h"
+
+#define TSPLSETUP_COMMAND_LENGTH	80
+
+// Job setup commands, see TSPLSETUP
+enum
+{
+	TSPLSETUP_SIZE = 0,
+	TSPLSETUP_GAP,
+	TSPLSETUP_SPEED,
+	TSPLSETUP_DENSITY,
+	TSPLSETUP_RIBBON,
+	TSPLSETUP_DIRECTION,
+	TSPLSETUP_REFERENCE,
+	TSPLSETUP_OFFSET,
+	TSPLSETUP_SHIFT,
+	TSPLSETUP_TEAR,
+	TSPLSETUP_PEEL,
+	TSPLSETUP_CUTTER,
+	TSPLSETUP_PARTIAL_CUTTER,
+	TSPLSETUP_COUNT
+};
+
+// dwFlags of TsplPageBitmap()
+#define TSPLBITMAP_BLACK1			0x0000		// Bit set = black dot, as CUPS raster and 1bpp BMP
+#define TSPLBITMAP_PRINTER			0x0001		// Bit clear = black dot, sent as is
+
+// Output of a job. pbuf is only valid during the call, it may point into the
+// rows passed to TsplPageBitmap(). Both return the bytes written, < 0 on error.
+typedef ssize_t (*PFN_TSPLWRITE)(void *pContext, const void *pbuf, size_t cbbuf);
+typedef ssize_t (*PFN_TSPLSENDFILE)(void *pContext, int fd, off_t offset, size_t count);
+
+typedef struct _TSPLSINK
+{
+	PFN_TSPLWRITE		pfnWrite;
+	PFN_TSPLSENDFILE	pfnSendFile;	// Optional, else the file is read and written
+	void				*pContext;
+} TSPLSINK;
+
+// What the printer is set up for. A job given one sends only the setup
+// commands that differ and leaves its own setup in it.
+typedef struct _TSPLSETUP
+{
+	BOOL		bLoaded;				// szCmds[] holds the printer setup
+	char		szCmds[TSPLSETUP_COUNT][TSPLSETUP_COMMAND_LENGTH];
+} TSPLSETUP;
+
+typedef struct _TSPLJOB TSPLJOB;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// pdm and pSetup are used, not copied, and must outlive the job. Changes to
+// pdm, such as dmCopies, apply to the commands sent after them.
+TSPLJOB*	TsplJobCreate(DEVMODE *pdm, const TSPLSINK *pSink, TSPLSETUP *pSetup);
+void		TsplJobDestroy(TSPLJOB *pJob);
+DEVMODE*	TsplJobDevmode(TSPLJOB *pJob);
+
+int			TsplJobStart(TSPLJOB *pJob);
+int			TsplJobAppend(TSPLJOB *pJob);
+int			TsplJobEnd(TSPLJOB *pJob);
+int			TsplJobCutInterval(TSPLJOB *pJob, unsigned nLabels);
+int			TsplPageStart(TSPLJOB *pJob);
+int			TsplPageEnd(TSPLJOB *pJob);
+int			TsplPageBitmap(TSPLJOB *pJob, int x, int y, int nWidth, int nHeight,
+							const BYTE *pRows, size_t cbStride, DWORD dwFlags);
+int			TsplPageBitmapFile(TSPLJOB *pJob, int x, int y, int nWidth, int nHeight, int fd, off_t offset);
+int			TsplPageBarcode(TSPLJOB *pJob, int x, int y, const char *pszType, int nHeight,
+							int nNarrow, int nWide, const char *pszData);
+
+int			TsplWrite(TSPLJOB *pJob, const void *pbuf, size_t cbbuf);
+int			TsplPrintf(TSPLJOB *pJob, const char *strfmt, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// #ifndef _TSPLENC_H_
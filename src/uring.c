@@ -0,0 +1,405 @@
+/*
+ * "uring.c 2026-10-17 10:12:40
+ *
+ *  io_uring output routine for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+// No liburing, the ring is driven with the raw system calls
+
+#include "config.h"
+#include "common.h"
+#include "debug.h"
+#include "uring.h"
+
+#ifdef HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup)
+
+#define	URING_ENTRIES				16			// Reads of all buffers and a write
+
+#define	URINGBUF_FREE				0
+#define	URINGBUF_FILLING			1			// Written to by UringOutWrite()
+#define	URINGBUF_READING			2			// Read from a file in flight
+#define	URINGBUF_READY				3			// Waiting for its write
+
+#define	URINGDATA_WRITE				0x100		// user_data, buffer index otherwise
+
+typedef struct _URINGBUF
+{
+	int			state;
+	size_t		cbData;					// Bytes of the buffer to write
+	size_t		cbDone;					// read in or written out so far
+	int			fdIn;					// URINGBUF_READING
+	off_t		offset;
+} URINGBUF;
+
+struct _URINGOUT
+{
+	int					fdOut;
+	int					fdRing;
+	BOOL				bFixed;				// Buffers are registered
+	BOOL				bError;
+	BOOL				bWriting;			// Write of the first buffer in flight
+	int					nInFlight;
+	unsigned			iFirst;				// Oldest queued buffer, written first
+	unsigned			nQueued;
+	URINGBUF			bufs[URING_BUFFERS];
+	BYTE				*pBuffers;
+
+	void				*pSqRing;
+	size_t				cbSqRing;
+	void				*pCqRing;
+	size_t				cbCqRing;
+	struct io_uring_sqe	*sqes;
+	size_t				cbSqes;
+	unsigned			*sqTail;
+	unsigned			*sqMask;
+	unsigned			*sqArray;
+	unsigned			*cqHead;
+	unsigned			*cqTail;
+	unsigned			*cqMask;
+	struct io_uring_cqe	*cqes;
+};
+
+static void UringSubmit(URINGOUT *pOut, int nOp, int fd, unsigned i, size_t cbDone, off_t offset, __u64 data);
+static void UringPump(URINGOUT *pOut);
+static void UringWait(URINGOUT *pOut);
+static void UringComplete(URINGOUT *pOut, __u64 data, int res);
+static URINGBUF* UringBuffer(URINGOUT *pOut);
+
+URINGOUT* UringOutCreate(int fdOut)
+{
+	struct io_uring_params	params;
+	struct iovec			iov[URING_BUFFERS];
+	URINGOUT				*pOut;
+	BYTE					*pSq;
+	BYTE					*pCq;
+	int						i;
+
+	if ( (pOut = MEMALLOC(sizeof(URINGOUT))) == NULL )
+		return NULL;
+	pOut->fdOut = fdOut;
+
+	memset(&params, 0, sizeof(params));
+	if ( (pOut->fdRing = syscall(__NR_io_uring_setup, URING_ENTRIES, &params)) < 0 )
+	{
+		// Old kernel, or io_uring turned off by sysctl or seccomp
+		DebugPrintf("UringOutCreate: io_uring_setup - %s\n", strerror(errno));
+		MEMFREE(pOut);
+		return NULL;
+	}
+
+	pOut->cbSqRing = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	pOut->cbCqRing = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	pOut->cbSqes = params.sq_entries * sizeof(struct io_uring_sqe);
+	pOut->pSqRing = mmap(NULL, pOut->cbSqRing, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pOut->fdRing, IORING_OFF_SQ_RING);
+	pOut->pCqRing = mmap(NULL, pOut->cbCqRing, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pOut->fdRing, IORING_OFF_CQ_RING);
+	pOut->sqes = mmap(NULL, pOut->cbSqes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pOut->fdRing, IORING_OFF_SQES);
+	pOut->pBuffers = MEMALLOC(URING_BUFFERS * URING_BUFFER_SIZE);
+	if ( pOut->pSqRing == MAP_FAILED || pOut->pCqRing == MAP_FAILED || pOut->sqes == MAP_FAILED || pOut->pBuffers == NULL )
+	{
+		DebugPrintf("UringOutCreate: %s\n", strerror(errno));
+		UringOutDestroy(pOut);
+		return NULL;
+	}
+
+	pSq = (BYTE*)pOut->pSqRing;
+	pCq = (BYTE*)pOut->pCqRing;
+	pOut->sqTail  = (unsigned*)(pSq + params.sq_off.tail);
+	pOut->sqMask  = (unsigned*)(pSq + params.sq_off.ring_mask);
+	pOut->sqArray = (unsigned*)(pSq + params.sq_off.array);
+	pOut->cqHead  = (unsigned*)(pCq + params.cq_off.head);
+	pOut->cqTail  = (unsigned*)(pCq + params.cq_off.tail);
+	pOut->cqMask  = (unsigned*)(pCq + params.cq_off.ring_mask);
+	pOut->cqes    = (struct io_uring_cqe*)(pCq + params.cq_off.cqes);
+
+	// Pinned memory counts against RLIMIT_MEMLOCK, plain reads and writes do without
+	for (i=0; i<URING_BUFFERS; i++)
+	{
+		iov[i].iov_base = pOut->pBuffers + i * URING_BUFFER_SIZE;
+		iov[i].iov_len = URING_BUFFER_SIZE;
+	}
+	pOut->bFixed = syscall(__NR_io_uring_register, pOut->fdRing, IORING_REGISTER_BUFFERS, iov, URING_BUFFERS) == 0;
+	if ( !pOut->bFixed )
+		DebugPrintf("UringOutCreate: IORING_REGISTER_BUFFERS - %s\n", strerror(errno));
+
+	return pOut;
+}
+
+void UringOutDestroy(URINGOUT *pOut)
+{
+	if ( pOut == NULL )
+		return;
+
+	// The kernel may still use the buffers of what is in flight
+	while ( pOut->nInFlight > 0 && pOut->pCqRing != MAP_FAILED )
+		UringWait(pOut);
+
+	if ( pOut->sqes && pOut->sqes != MAP_FAILED )
+		munmap(pOut->sqes, pOut->cbSqes);
+	if ( pOut->pCqRing && pOut->pCqRing != MAP_FAILED )
+		munmap(pOut->pCqRing, pOut->cbCqRing);
+	if ( pOut->pSqRing && pOut->pSqRing != MAP_FAILED )
+		munmap(pOut->pSqRing, pOut->cbSqRing);
+	close(pOut->fdRing);
+	MEMFREE(pOut->pBuffers);
+	MEMFREE(pOut);
+}
+
+ssize_t UringOutWrite(URINGOUT *pOut, const void *pbuf, size_t cbbuf)
+{
+	const BYTE	*p = (const BYTE*)pbuf;
+	size_t		cbLeft = cbbuf;
+
+	while ( cbLeft > 0 && !pOut->bError )
+	{
+		URINGBUF	*buf = pOut->nQueued ? &pOut->bufs[(pOut->iFirst + pOut->nQueued - 1) % URING_BUFFERS] : NULL;
+		size_t		cb;
+
+		if ( buf == NULL || buf->state != URINGBUF_FILLING || buf->cbData == URING_BUFFER_SIZE )
+		{
+			if ( (buf = UringBuffer(pOut)) == NULL )
+				break;
+			buf->state = URINGBUF_FILLING;
+		}
+
+		cb = min(cbLeft, URING_BUFFER_SIZE - buf->cbData);
+		memcpy(pOut->pBuffers + (buf - pOut->bufs) * URING_BUFFER_SIZE + buf->cbData, p, cb);
+		buf->cbData += cb;
+		p += cb;
+		cbLeft -= cb;
+
+		if ( buf->cbData == URING_BUFFER_SIZE )
+		{
+			buf->state = URINGBUF_READY;
+			UringPump(pOut);
+		}
+	}
+
+	if ( pOut->bError )
+		return -1;
+	return cbbuf;
+}
+
+ssize_t UringOutSendFile(URINGOUT *pOut, int fdIn, off_t offset, size_t count)
+{
+	size_t		nLeft = count;
+	URINGBUF	*buf;
+
+	while ( nLeft > 0 && !pOut->bError )
+	{
+		if ( (buf = UringBuffer(pOut)) == NULL )
+			break;
+		buf->state = URINGBUF_READING;
+		buf->cbData = min(nLeft, URING_BUFFER_SIZE);
+		buf->fdIn = fdIn;
+		buf->offset = offset;
+		UringSubmit(pOut, pOut->bFixed ? IORING_OP_READ_FIXED : IORING_OP_READ,
+					fdIn, buf - pOut->bufs, 0, offset, buf - pOut->bufs);
+		offset += buf->cbData;
+		nLeft -= buf->cbData;
+	}
+
+	if ( pOut->bError )
+		return -1;
+	return count;
+}
+
+// Everything queued is written. Returns 0, -1 if a read or write failed.
+int UringOutFlush(URINGOUT *pOut)
+{
+	if ( pOut->nQueued )
+	{
+		URINGBUF	*buf = &pOut->bufs[(pOut->iFirst + pOut->nQueued - 1) % URING_BUFFERS];
+
+		if ( buf->state == URINGBUF_FILLING )
+			buf->state = URINGBUF_READY;
+		UringPump(pOut);
+	}
+
+	while ( (pOut->nQueued && !pOut->bError) || pOut->nInFlight > 0 )
+		UringWait(pOut);
+
+	return pOut->bError ? -1 : 0;
+}
+
+// A free buffer at the end of the queue, waits for the oldest write if none.
+URINGBUF* UringBuffer(URINGOUT *pOut)
+{
+	URINGBUF	*buf;
+
+	if ( pOut->nQueued )
+	{
+		buf = &pOut->bufs[(pOut->iFirst + pOut->nQueued - 1) % URING_BUFFERS];
+		if ( buf->state == URINGBUF_FILLING )
+		{
+			buf->state = URINGBUF_READY;
+			UringPump(pOut);
+		}
+	}
+
+	while ( pOut->nQueued == URING_BUFFERS && !pOut->bError )
+		UringWait(pOut);
+	if ( pOut->bError )
+		return NULL;
+
+	buf = &pOut->bufs[(pOut->iFirst + pOut->nQueued) % URING_BUFFERS];
+	memset(buf, 0, sizeof(URINGBUF));
+	pOut->nQueued ++;
+	return buf;
+}
+
+void UringSubmit(URINGOUT *pOut, int nOp, int fd, unsigned i, size_t cbDone, off_t offset, __u64 data)
+{
+	unsigned			tail = *pOut->sqTail;
+	unsigned			index = tail & *pOut->sqMask;
+	struct io_uring_sqe	*sqe = &pOut->sqes[index];
+	int					iRtn;
+
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+	sqe->opcode = nOp;
+	sqe->fd = fd;
+	sqe->addr = (__u64)(unsigned long)(pOut->pBuffers + i * URING_BUFFER_SIZE + cbDone);
+	sqe->len = pOut->bufs[i].cbData - cbDone;
+	sqe->off = offset;
+	sqe->buf_index = i;
+	sqe->user_data = data;
+	pOut->sqArray[index] = index;
+	__atomic_store_n(pOut->sqTail, tail + 1, __ATOMIC_RELEASE);
+
+	while ( (iRtn = syscall(__NR_io_uring_enter, pOut->fdRing, 1, 0, 0, NULL, 0)) < 0 && errno == EINTR )
+		;
+	if ( iRtn < 1 )
+	{
+		Error_Log(LEVEL_ERROR, "IO error: io_uring_enter - %s\n", strerror(errno));
+		pOut->bError = TRUE;
+		return;
+	}
+	pOut->nInFlight ++;
+}
+
+// The output is a stream, one write at a time keeps it in order
+void UringPump(URINGOUT *pOut)
+{
+	URINGBUF	*buf = &pOut->bufs[pOut->iFirst];
+
+	if ( pOut->bError || pOut->bWriting || pOut->nQueued == 0 || buf->state != URINGBUF_READY )
+		return;
+
+	pOut->bWriting = TRUE;
+	UringSubmit(pOut, pOut->bFixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE,
+				pOut->fdOut, pOut->iFirst, buf->cbDone, (off_t)-1, URINGDATA_WRITE | pOut->iFirst);
+}
+
+void UringWait(URINGOUT *pOut)
+{
+	unsigned	head = *pOut->cqHead;
+	unsigned	tail = __atomic_load_n(pOut->cqTail, __ATOMIC_ACQUIRE);
+
+	if ( head == tail )
+	{
+		if ( syscall(__NR_io_uring_enter, pOut->fdRing, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR )
+		{
+			Error_Log(LEVEL_ERROR, "IO error: io_uring_enter - %s\n", strerror(errno));
+			pOut->bError = TRUE;
+			pOut->nInFlight = 0;
+		}
+		return;
+	}
+
+	for (; head != tail; head++)
+	{
+		struct io_uring_cqe	*cqe = &pOut->cqes[head & *pOut->cqMask];
+
+		pOut->nInFlight --;
+		UringComplete(pOut, cqe->user_data, cqe->res);
+	}
+	__atomic_store_n(pOut->cqHead, head, __ATOMIC_RELEASE);
+	UringPump(pOut);
+}
+
+void UringComplete(URINGOUT *pOut, __u64 data, int res)
+{
+	unsigned	i = data & ~URINGDATA_WRITE;
+	URINGBUF	*buf = &pOut->bufs[i];
+	BOOL		bWrite = (data & URINGDATA_WRITE) != 0;
+
+	if ( res == -EINTR || res == -EAGAIN )
+		res = 0;
+	else if ( res < 0 || (res == 0 && !bWrite) )
+	{
+		// A read at the end of the file is a page store cut short
+		Error_Log(LEVEL_ERROR, "IO error: %s\n", strerror(res < 0 ? -res : EIO));
+		pOut->bError = TRUE;
+		if ( bWrite )
+			pOut->bWriting = FALSE;
+		return;
+	}
+
+	buf->cbDone += res;
+	if ( bWrite )
+	{
+		pOut->bWriting = FALSE;
+		if ( buf->cbDone == buf->cbData )
+		{
+			buf->state = URINGBUF_FREE;
+			pOut->iFirst = (pOut->iFirst + 1) % URING_BUFFERS;
+			pOut->nQueued --;
+		}
+	}
+	else if ( buf->cbDone < buf->cbData )
+		UringSubmit(pOut, pOut->bFixed ? IORING_OP_READ_FIXED : IORING_OP_READ,
+					buf->fdIn, i, buf->cbDone, buf->offset + buf->cbDone, i);
+	else
+	{
+		buf->cbDone = 0;
+		buf->state = URINGBUF_READY;
+	}
+}
+
+#else	// io_uring
+
+URINGOUT* UringOutCreate(int fdOut)
+{
+	return NULL;
+}
+
+void UringOutDestroy(URINGOUT *pOut)
+{
+}
+
+ssize_t UringOutWrite(URINGOUT *pOut, const void *pbuf, size_t cbbuf)
+{
+	return -1;
+}
+
+ssize_t UringOutSendFile(URINGOUT *pOut, int fdIn, off_t offset, size_t count)
+{
+	return -1;
+}
+
+int UringOutFlush(URINGOUT *pOut)
+{
+	return 0;
+}
+
+#endif	// io_uring
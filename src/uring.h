@@ -0,0 +1,53 @@
+/*
+ * "uring.h 2026-10-17 10:12:40
+ *
+ *  io_uring output routine declaration for TSC Printer Driver
+ *
+ *  Copyright (c) 2005, by TSC Printronix Auto ID .
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+
+ *      http://www.apache.org/licenses/LICENSE-2.0
+
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+/*
+	Write-behind output through io_uring. Data is copied to a few buffers
+	registered with the ring and written in order while the caller goes
+	on; a file sent is read into them with its reads in flight next to
+	the writes. UringOutCreate() returns NULL when the kernel or the
+	build has no io_uring, the caller then writes as before.
+*/
+
+#ifndef _URING_H_
+#define _URING_H_
+
+#include "common.h"
+
+#define	URING_BUFFERS				8
+#define	URING_BUFFER_SIZE			65536
+
+typedef struct _URINGOUT URINGOUT;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+URINGOUT*	UringOutCreate(int fdOut);
+void		UringOutDestroy(URINGOUT *pOut);
+ssize_t		UringOutWrite(URINGOUT *pOut, const void *pbuf, size_t cbbuf);
+ssize_t		UringOutSendFile(URINGOUT *pOut, int fdIn, off_t offset, size_t count);
+int			UringOutFlush(URINGOUT *pOut);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// #ifndef _URING_H_